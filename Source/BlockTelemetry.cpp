@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    BlockTelemetry.cpp
+
+  ==============================================================================
+*/
+
+#include "BlockTelemetry.h"
+
+//==============================================================================
+void BlockTelemetry::recordBlock(double blockMs, int numChannelSamples, const CompressorStats& stats) noexcept
+{
+    if (resetRequested.exchange(false, std::memory_order_relaxed))
+        clear();
+
+    auto microseconds = blockMs * 1000.0;
+    auto bucket = microseconds < 1.0 ? 0 : juce::jmin(numTimeBuckets - 1, 1 + (int) std::log2(microseconds));
+
+    // Single writer, so plain load/store pairs are enough
+    auto bump = [] (std::atomic<juce::uint64>& counter, juce::uint64 amount)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    };
+
+    bump(blockTimeHistogram[bucket], 1);
+    bump(numBlocks, 1);
+    bump(numSamples, (juce::uint64) numChannelSamples);
+    bump(samplesOverThreshold, (juce::uint64) stats.samplesOverThreshold);
+
+    auto gainReductionDb = -juce::Decibels::gainToDecibels(stats.minGain, -100.0f);
+
+    if (gainReductionDb > peakGainReductionDb.load(std::memory_order_relaxed))
+        peakGainReductionDb.store(gainReductionDb, std::memory_order_relaxed);
+}
+
+BlockTelemetry::Snapshot BlockTelemetry::getSnapshot() const noexcept
+{
+    Snapshot snapshot;
+    snapshot.numBlocks = numBlocks.load(std::memory_order_relaxed);
+    snapshot.numSamples = numSamples.load(std::memory_order_relaxed);
+    snapshot.samplesOverThreshold = samplesOverThreshold.load(std::memory_order_relaxed);
+    snapshot.peakGainReductionDb = peakGainReductionDb.load(std::memory_order_relaxed);
+
+    for (int bucket = 0; bucket < numTimeBuckets; ++bucket)
+        snapshot.blockTimeHistogram[(size_t) bucket] = blockTimeHistogram[bucket].load(std::memory_order_relaxed);
+
+    return snapshot;
+}
+
+void BlockTelemetry::clear() noexcept
+{
+    for (auto& count : blockTimeHistogram)
+        count.store(0, std::memory_order_relaxed);
+
+    numBlocks.store(0, std::memory_order_relaxed);
+    numSamples.store(0, std::memory_order_relaxed);
+    samplesOverThreshold.store(0, std::memory_order_relaxed);
+    peakGainReductionDb.store(0.0f, std::memory_order_relaxed);
+}
+
+//==============================================================================
+double BlockTelemetry::Snapshot::getFractionOverThreshold() const
+{
+    return numSamples > 0 ? (double) samplesOverThreshold / (double) numSamples : 0.0;
+}
+
+double BlockTelemetry::Snapshot::getBlockTimePercentileMs(double percentile) const
+{
+    juce::uint64 total = 0;
+
+    for (auto count : blockTimeHistogram)
+        total += count;
+
+    if (total == 0)
+        return 0.0;
+
+    auto target = (juce::uint64) std::ceil((double) total * juce::jlimit(0.0, 100.0, percentile) / 100.0);
+    juce::uint64 cumulative = 0;
+
+    for (int bucket = 0; bucket < numTimeBuckets; ++bucket)
+    {
+        cumulative += blockTimeHistogram[(size_t) bucket];
+
+        if (cumulative >= target)
+            return getBucketUpperEdgeMs(bucket);
+    }
+
+    return getBucketUpperEdgeMs(numTimeBuckets - 1);
+}
+
+juce::String BlockTelemetry::Snapshot::getCsvHeader()
+{
+    juce::String header ("blocks,samples,fraction_over_threshold,peak_gain_reduction_db,p50_ms,p99_ms");
+
+    for (int bucket = 0; bucket < numTimeBuckets; ++bucket)
+        header << ",lt_" << juce::String(getBucketUpperEdgeMs(bucket), 3) << "ms";
+
+    return header;
+}
+
+juce::String BlockTelemetry::Snapshot::toCsvRow() const
+{
+    juce::String row;
+    row << juce::String((juce::int64) numBlocks) << ","
+        << juce::String((juce::int64) numSamples) << ","
+        << juce::String(getFractionOverThreshold(), 6) << ","
+        << juce::String(peakGainReductionDb, 2) << ","
+        << juce::String(getBlockTimePercentileMs(50.0), 3) << ","
+        << juce::String(getBlockTimePercentileMs(99.0), 3);
+
+    for (auto count : blockTimeHistogram)
+        row << "," << juce::String((juce::int64) count);
+
+    return row;
+}
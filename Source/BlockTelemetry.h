@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    BlockTelemetry.h
+    Per-block timing histogram and compressor activity, written by the audio
+    thread without locks and read from anywhere.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CompressorKernel.h"
+
+//==============================================================================
+class BlockTelemetry
+{
+public:
+    // Bucket 0 holds blocks under 1us, bucket b holds [2^(b-1), 2^b) us
+    static constexpr int numTimeBuckets = 24;
+
+    struct Snapshot
+    {
+        juce::uint64 numBlocks = 0;
+        juce::uint64 numSamples = 0;           // Channel samples, i.e. frames * channels
+        juce::uint64 samplesOverThreshold = 0;
+        float peakGainReductionDb = 0.0f;      // Largest reduction applied, as a positive dB value
+        std::array<juce::uint64, numTimeBuckets> blockTimeHistogram {};
+
+        double getFractionOverThreshold() const;
+
+        // Upper edge of the bucket containing the given percentile (0-100)
+        double getBlockTimePercentileMs(double percentile) const;
+
+        static juce::String getCsvHeader();
+        juce::String toCsvRow() const;
+    };
+
+    BlockTelemetry() = default;
+
+    // Audio thread only
+    void recordBlock(double blockMs, int numChannelSamples, const CompressorStats& stats) noexcept;
+
+    // Any thread
+    Snapshot getSnapshot() const noexcept;
+
+    // Any thread; the counters are cleared by the audio thread on its next block
+    // so that it stays the only writer
+    void reset() noexcept { resetRequested.store(true, std::memory_order_relaxed); }
+
+    static double getBucketUpperEdgeMs(int bucket) { return std::ldexp(1.0, bucket) / 1000.0; }
+
+private:
+    void clear() noexcept;
+
+    std::atomic<juce::uint64> blockTimeHistogram[numTimeBuckets] {};
+    std::atomic<juce::uint64> numBlocks { 0 };
+    std::atomic<juce::uint64> numSamples { 0 };
+    std::atomic<juce::uint64> samplesOverThreshold { 0 };
+    std::atomic<float> peakGainReductionDb { 0.0f };
+    std::atomic<bool> resetRequested { false };
+
+    JUCE_DECLARE_NON_COPYABLE (BlockTelemetry)
+};
@@ -0,0 +1,300 @@
+/*
+  ==============================================================================
+
+    CompressorKernel.h
+    The per-channel compression loop, shared by processBlock and anything
+    else that needs to run the exact DSP the plugin runs.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Block-constant settings, resolved once from the parameters per host block.
+*/
+struct CompressorSettings
+{
+    float linearThreshold = 1.0f;
+    float ratio = 1.0f;
+    float attackCoeff = 1.0f;
+    float releaseCoeff = 1.0f;
+    float linearGain = 1.0f;
+    
+    bool feedback = false;       // Detector driven by the previous output sample instead of the input
+    bool autoRelease = false;    // Program-dependent release from a second, slower gain stage
+    float slowAttackCoeff = 1.0f;  // Per slowStageStride samples, not per sample
+    float slowReleaseCoeff = 1.0f;
+};
+
+/**
+    Detector state for one channel, carried between calls.
+*/
+struct CompressorChannelState
+{
+    float envelope = 0.0f;  // Feed-forward detector: the output's excess above the threshold
+    float reduction = 0.0f; // Feedback detector: the excess taken off the input
+    
+    // Auto-release stage, as a linear gain, and the stride it's collecting
+    float slowGain = 1.0f;
+    float strideMinGain = 1.0f;
+    int strideFill = 0;
+};
+
+/**
+    What the kernel did, accumulated across calls for telemetry and metering.
+*/
+struct CompressorStats
+{
+    int samplesOverThreshold = 0;
+    float minGain = 1.0f; // Smallest output/input magnitude applied by the compressor
+};
+
+//==============================================================================
+namespace CompressorKernel
+{
+    // The auto-release slow stage's attack and release times, relative to the knobs
+    constexpr float slowStageTimeScale = 10.0f;
+    
+    // The slow stage steps once per this many samples, so its per-sample work is
+    // a pass the compiler can vectorize
+    constexpr int slowStageStride = 16;
+    
+    // Auto release works through runs of at most this many samples, which bounds
+    // the detector gains it keeps between its two passes
+    constexpr int maxRunLength = 256;
+    
+    // The feed-forward detector: the original algorithm, unchanged. With auto
+    // release, the audio is left as it is and each sample's gain, at most unity,
+    // goes to gains for applySlowStage instead.
+    template <bool autoRelease>
+    inline void processFeedForward(float* channelData, float* gains, int numSamples, CompressorChannelState& state,
+                                   const CompressorSettings& settings, CompressorStats& stats)
+    {
+        auto env = state.envelope;
+        auto samplesOverThreshold = 0;
+        auto minGain = stats.minGain;
+
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            auto& sampleValue = channelData[sample];
+
+            if (std::abs(sampleValue) > settings.linearThreshold){
+                // Calculate the excess above the threshold
+                float excess = std::abs(sampleValue) - settings.linearThreshold;
+
+                // Smooth the gain reduction using the envelope
+                float targetEnvelope = excess / settings.ratio; // Amount of reduction based on ratio
+                env = env + settings.attackCoeff * (targetEnvelope - env); // Attack smoothing
+
+                // Apply compression
+                float compressedSample = settings.linearThreshold + env;
+                minGain = juce::jmin(minGain, compressedSample / std::abs(sampleValue));
+                ++samplesOverThreshold;
+                
+                if constexpr (autoRelease)
+                    gains[sample] = juce::jmin(1.0f, compressedSample / std::abs(sampleValue)); // Unity for Inf too
+                else
+                    sampleValue = (sampleValue > 0.0f ? compressedSample : -compressedSample); // Preserve polarity
+            }
+            else {
+                // Release the envelope
+                env = env - settings.releaseCoeff * env;
+                env = juce::jmax(env, 0.0f); // Ensure envelope doesn't go negative
+                
+                if constexpr (autoRelease)
+                    gains[sample] = 1.0f;
+            }
+
+            // Apply final gain
+            if constexpr (! autoRelease)
+                sampleValue *= settings.linearGain;
+        }
+
+        state.envelope = env;
+        stats.samplesOverThreshold += samplesOverThreshold;
+        stats.minGain = minGain;
+    }
+    
+    // The feedback detector takes its reduction from the previous output sample instead of the input: an output
+    // excess y calls for (ratio - 1) * y of reduction, which gives the same static
+    // curve as feed-forward, y = x / ratio for an input excess x. The loop multiplies
+    // each step by the ratio, so the same knob attacks and releases about ratio times
+    // faster than in feed-forward; steps are capped at 1 / ratio to keep the loop
+    // from overshooting. The first sample of an onset goes through uncompressed, as
+    // in analogue feedback designs.
+    //
+    // With auto release, the audio is left as it is and each sample's gain goes to
+    // gains for applySlowStage instead, as in processFeedForward.
+    template <bool autoRelease>
+    inline void processFeedback(float* channelData, float* gains, int numSamples, CompressorChannelState& state,
+                                const CompressorSettings& settings, CompressorStats& stats)
+    {
+        auto threshold = settings.linearThreshold;
+        
+        // While y = x - reduction > 0, the step reduction + c * ((ratio - 1) * y - reduction)
+        // is reduction * (1 - c * ratio) + c * (ratio - 1) * x, a line in the reduction;
+        // once y = 0 it's a release towards zero. Picking attack or release by the sign
+        // of the change makes the step a continuous, piecewise-linear function of the
+        // reduction: the max of the three lines when attack is the faster, otherwise
+        // the max of the idle line and the min of the other two. That keeps selects
+        // and mispredicts out of the loop-carried chain.
+        auto attackCoeff = juce::jmin(settings.attackCoeff, 1.0f / settings.ratio);
+        auto releaseCoeff = juce::jmin(settings.releaseCoeff, 1.0f / settings.ratio);
+        auto attackKeep = 1.0f - attackCoeff * settings.ratio;
+        auto attackStep = attackCoeff * (settings.ratio - 1.0f);
+        auto releaseKeep = 1.0f - releaseCoeff * settings.ratio;
+        auto releaseStep = releaseCoeff * (settings.ratio - 1.0f);
+        auto idleKeep = 1.0f - releaseCoeff;
+        auto attackIsFaster = attackCoeff >= releaseCoeff;
+        auto reduction = state.reduction;
+        auto samplesOverThreshold = 0;
+        auto minGain = stats.minGain;
+        
+        for (int i = 0; i < numSamples; ++i)
+        {
+            // Take off what the previous outputs called for, but never below the threshold.
+            // NaN counts as no excess, so it can't poison the detector.
+            auto magnitude = std::abs(channelData[i]);
+            auto excess = juce::jmax(0.0f, magnitude - threshold);
+            auto compressedMagnitude = juce::jmin(magnitude, juce::jmax(magnitude - reduction, threshold));
+            auto gain = juce::jmin(1.0f, compressedMagnitude / magnitude); // Unity for silence and NaN too
+            minGain = juce::jmin(minGain, gain);
+            samplesOverThreshold += magnitude > threshold ? 1 : 0;
+
+            if constexpr (autoRelease)
+                gains[i] = gain;
+            else
+                channelData[i] = std::copysign(compressedMagnitude, channelData[i]) * settings.linearGain; // Preserve polarity
+
+            // This sample's output sets the reduction for the next one
+            auto attacked = reduction * attackKeep + attackStep * excess;
+            auto released = reduction * releaseKeep + releaseStep * excess;
+            auto idle = reduction * idleKeep;
+            reduction = juce::jmax(attackIsFaster ? juce::jmax(attacked, released) : juce::jmin(attacked, released), idle);
+        }
+        
+        state.reduction = reduction;
+        stats.minGain = minGain;
+        stats.samplesOverThreshold += samplesOverThreshold;
+    }
+    
+    // Scales at most a stride of samples by min(gain, slowGain) and the makeup gain,
+    // and returns the lowest of the gains. The minimum is a halving tree over the
+    // whole stride, padded with unity, so it vectorizes too.
+    inline float applySlowGain(float* samples, const float* gains, int numSamples, float slowGain, float linearGain)
+    {
+        std::array<float, slowStageStride> lanes;
+        lanes.fill(1.0f);
+        std::copy_n(gains, numSamples, lanes.begin());
+
+        for (int i = 0; i < numSamples; ++i)
+            samples[i] *= juce::jmin(lanes[(size_t) i], slowGain) * linearGain;
+
+        for (int width = slowStageStride / 2; width > 0; width /= 2)
+            for (int i = 0; i < width; ++i)
+                lanes[(size_t) i] = juce::jmin(lanes[(size_t) i], lanes[(size_t) (i + width)]);
+
+        return lanes[0];
+    }
+    
+    // Auto release, as its own pass over a run the detector has just measured:
+    // each sample is scaled by min(detector gain, slow gain) and the makeup gain.
+    // The slow gain holds for a stride, then steps towards the lowest detector gain
+    // in it, at its attack going down and its release coming back up. A short peak
+    // barely moves it, so recovery stays fast; sustained reduction charges it, and
+    // it then holds the gain down for its slower release, below the threshold too.
+    //
+    // Strides carry over between calls and min is exact, so the result doesn't
+    // depend on how the audio is split.
+    inline void applySlowStage(float* channelData, const float* gains, int numSamples, CompressorChannelState& state,
+                               const CompressorSettings& settings, CompressorStats& stats)
+    {
+        auto slowGain = state.slowGain;
+        auto strideMinGain = state.strideMinGain;
+        auto strideFill = state.strideFill;
+        auto minGain = stats.minGain;
+
+        for (int start = 0; start < numSamples;)
+        {
+            auto length = juce::jmin(slowStageStride - strideFill, numSamples - start);
+            auto* samples = channelData + start;
+            auto* strideGains = gains + start;
+
+            // Full strides, the usual case, take a constant length the compiler unrolls
+            auto lowest = length == slowStageStride
+                              ? applySlowGain(samples, strideGains, slowStageStride, slowGain, settings.linearGain)
+                              : applySlowGain(samples, strideGains, length, slowGain, settings.linearGain);
+            strideMinGain = juce::jmin(strideMinGain, lowest);
+            minGain = juce::jmin(minGain, juce::jmin(lowest, slowGain));
+            strideFill += length;
+            start += length;
+
+            if (strideFill == slowStageStride)
+            {
+                auto coeff = strideMinGain < slowGain ? settings.slowAttackCoeff : settings.slowReleaseCoeff;
+                slowGain = slowGain + coeff * (strideMinGain - slowGain);
+                strideMinGain = 1.0f;
+                strideFill = 0;
+            }
+        }
+
+        state.slowGain = slowGain;
+        state.strideMinGain = strideMinGain;
+        state.strideFill = strideFill;
+        stats.minGain = minGain;
+    }
+    
+    // Compresses one channel in place. The state is the channel's own, so the
+    // result doesn't depend on how many samples are passed per call. The topology
+    // or stage that isn't in use is kept at rest, to start from there when switched on.
+    inline void process(float* channelData, int numSamples, CompressorChannelState& state, const CompressorSettings& settings,
+                        CompressorStats& stats)
+    {
+        if (settings.feedback)
+            state.envelope = 0.0f;
+        else
+            state.reduction = 0.0f;
+
+        if (! settings.autoRelease)
+        {
+            state.slowGain = 1.0f;
+            state.strideMinGain = 1.0f;
+            state.strideFill = 0;
+        }
+        
+        if (! settings.autoRelease)
+        {
+            if (settings.feedback)
+                processFeedback<false>(channelData, nullptr, numSamples, state, settings, stats);
+            else
+                processFeedForward<false>(channelData, nullptr, numSamples, state, settings, stats);
+            
+            return;
+        }
+        
+        std::array<float, maxRunLength> gains;
+
+        for (int start = 0; start < numSamples; start += maxRunLength)
+        {
+            auto* run = channelData + start;
+            auto length = juce::jmin(maxRunLength, numSamples - start);
+
+            if (settings.feedback)
+                processFeedback<true>(run, gains.data(), length, state, settings, stats);
+            else
+                processFeedForward<true>(run, gains.data(), length, state, settings, stats);
+
+            applySlowStage(run, gains.data(), length, state, settings, stats);
+        }
+    }
+    
+    // The detector's current level, in the same units as the excess above the threshold
+    inline float getEnvelope(const CompressorChannelState& state, const CompressorSettings& settings)
+    {
+        return settings.feedback ? state.reduction : state.envelope;
+    }
+}
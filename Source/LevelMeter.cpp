@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    LevelMeter.cpp
+
+  ==============================================================================
+*/
+
+#include "LevelMeter.h"
+
+namespace
+{
+    constexpr float peakFallDbPerSecond = 20.0f;
+    constexpr double rmsTimeConstantSeconds = 0.3;
+}
+
+//==============================================================================
+LevelMeter::LevelMeter(Style meterStyle)
+    : style(meterStyle),
+      minDb(meterStyle == Style::level ? -60.0f : 0.0f),
+      maxDb(meterStyle == Style::level ? 0.0f : 24.0f)
+{
+    displayedPeakDb = displayedRmsDb = (style == Style::level ? minDb : 0.0f);
+    setOpaque(true);
+    setInterceptsMouseClicks(false, false);
+}
+
+void LevelMeter::update(float peakGain, float rmsGain, double elapsedSeconds)
+{
+    if (style == Style::level)
+    {
+        auto peakDb = juce::Decibels::gainToDecibels(peakGain, minDb);
+        auto rmsDb = juce::Decibels::gainToDecibels(rmsGain, minDb);
+
+        // Peak: instant rise, linear fall. RMS: one-pole smoothing in dB.
+        displayedPeakDb = juce::jmax(peakDb, displayedPeakDb - peakFallDbPerSecond * (float) elapsedSeconds);
+        displayedRmsDb += (float) (1.0 - std::exp(-elapsedSeconds / rmsTimeConstantSeconds)) * (rmsDb - displayedRmsDb);
+    }
+    else
+    {
+        auto reductionDb = -juce::Decibels::gainToDecibels(peakGain, -maxDb);
+        displayedPeakDb = juce::jmax(reductionDb, displayedPeakDb - peakFallDbPerSecond * (float) elapsedSeconds);
+        displayedRmsDb = displayedPeakDb;
+    }
+
+    auto peakY = juce::roundToInt(dbToY(displayedPeakDb));
+    auto rmsY = juce::roundToInt(dbToY(displayedRmsDb));
+
+    if (peakY != drawnPeakY || rmsY != drawnRmsY)
+    {
+        drawnPeakY = peakY;
+        drawnRmsY = rmsY;
+        repaint();
+    }
+}
+
+void LevelMeter::paint(juce::Graphics& g)
+{
+    g.drawImageAt(background, 0, 0);
+
+    auto bar = getLocalBounds().reduced(2).toFloat();
+
+    if (style == Style::level)
+    {
+        g.setColour(juce::Colours::orange);
+        g.fillRect(bar.withTop(dbToY(displayedRmsDb)));
+
+        g.setColour(juce::Colours::white);
+        g.fillRect(bar.withTop(dbToY(displayedPeakDb)).withHeight(2.0f));
+    }
+    else
+    {
+        g.setColour(juce::Colours::violet);
+        g.fillRect(bar.withBottom(dbToY(displayedPeakDb)));
+    }
+}
+
+void LevelMeter::resized()
+{
+    renderBackground();
+    drawnPeakY = drawnRmsY = -1;
+}
+
+//==============================================================================
+float LevelMeter::dbToY(float db) const
+{
+    auto bar = getLocalBounds().reduced(2).toFloat();
+    auto proportion = juce::jlimit(0.0f, 1.0f, (db - minDb) / (maxDb - minDb));
+
+    return style == Style::level ? bar.getBottom() - proportion * bar.getHeight()
+                                 : bar.getY() + proportion * bar.getHeight();
+}
+
+void LevelMeter::renderBackground()
+{
+    if (getWidth() <= 0 || getHeight() <= 0)
+    {
+        background = {};
+        return;
+    }
+
+    background = juce::Image(juce::Image::RGB, getWidth(), getHeight(), true);
+    juce::Graphics g(background);
+
+    g.fillAll(juce::Colours::white);
+    g.setColour(juce::Colours::black);
+    g.fillRoundedRectangle(getLocalBounds().toFloat(), 2.0f);
+
+    // A tick every 6dB
+    g.setColour(juce::Colours::darkslategrey);
+
+    for (auto db = minDb; db <= maxDb; db += 6.0f)
+        g.fillRect(juce::Rectangle<float>(0.0f, dbToY(db), (float) getWidth(), 1.0f));
+}
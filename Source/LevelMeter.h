@@ -0,0 +1,147 @@
+/*
+  ==============================================================================
+
+    LevelMeter.h
+    Input/output/gain-reduction metering: the audio thread publishes raw
+    block levels, the editor applies ballistics and draws them.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Lock-free hand-over of block levels. Peaks are held and RMS energy is
+    summed until the editor takes them, so short transients between timer
+    ticks aren't lost and the RMS covers the whole interval, not just the
+    last block.
+*/
+class LevelMeterSource
+{
+public:
+    struct Levels
+    {
+        float inputPeak = 0.0f;
+        float inputRms = 0.0f;
+        float outputPeak = 0.0f;
+        float outputRms = 0.0f;
+        float gain = 1.0f; // Smallest gain the compressor applied
+    };
+
+    // What processBlock measures over one block, across all channels
+    struct BlockLevels
+    {
+        float inputPeak = 0.0f;
+        float outputPeak = 0.0f;
+        double inputSumOfSquares = 0.0;
+        double outputSumOfSquares = 0.0;
+        int numChannelSamples = 0;
+        float gain = 1.0f;
+    };
+
+    // Audio thread
+    void publish(const BlockLevels& block) noexcept
+    {
+        raiseTo(inputPeak, block.inputPeak);
+        raiseTo(outputPeak, block.outputPeak);
+        lowerTo(gain, block.gain);
+        
+        // Sums before the count, which take() reads first; a block landing
+        // mid-take is at worst split across two readings
+        addTo(inputSumOfSquares, block.inputSumOfSquares);
+        addTo(outputSumOfSquares, block.outputSumOfSquares);
+        numChannelSamples.fetch_add(block.numChannelSamples, std::memory_order_release);
+    }
+
+    // Message thread: returns what was held since the last call and rearms the holds
+    Levels take() noexcept
+    {
+        Levels levels;
+        levels.inputPeak = inputPeak.exchange(0.0f, std::memory_order_relaxed);
+        levels.outputPeak = outputPeak.exchange(0.0f, std::memory_order_relaxed);
+        levels.gain = gain.exchange(1.0f, std::memory_order_relaxed);
+        
+        auto count = numChannelSamples.exchange(0, std::memory_order_acquire);
+        auto inputSum = inputSumOfSquares.exchange(0.0, std::memory_order_relaxed);
+        auto outputSum = outputSumOfSquares.exchange(0.0, std::memory_order_relaxed);
+        
+        // With no audio since the last call, the previous reading stands
+        if (count > 0)
+        {
+            lastInputRms = (float) std::sqrt(juce::jmax(0.0, inputSum) / (double) count);
+            lastOutputRms = (float) std::sqrt(juce::jmax(0.0, outputSum) / (double) count);
+        }
+        
+        levels.inputRms = lastInputRms;
+        levels.outputRms = lastOutputRms;
+        return levels;
+    }
+
+private:
+    static void raiseTo(std::atomic<float>& value, float newValue) noexcept
+    {
+        auto current = value.load(std::memory_order_relaxed);
+        while (newValue > current && ! value.compare_exchange_weak(current, newValue, std::memory_order_relaxed)) {}
+    }
+
+    static void lowerTo(std::atomic<float>& value, float newValue) noexcept
+    {
+        auto current = value.load(std::memory_order_relaxed);
+        while (newValue < current && ! value.compare_exchange_weak(current, newValue, std::memory_order_relaxed)) {}
+    }
+
+    static void addTo(std::atomic<double>& value, double amount) noexcept
+    {
+        auto current = value.load(std::memory_order_relaxed);
+        while (! value.compare_exchange_weak(current, current + amount, std::memory_order_relaxed)) {}
+    }
+
+    std::atomic<float> inputPeak { 0.0f };
+    std::atomic<float> outputPeak { 0.0f };
+    std::atomic<float> gain { 1.0f };
+    std::atomic<double> inputSumOfSquares { 0.0 };
+    std::atomic<double> outputSumOfSquares { 0.0 };
+    std::atomic<juce::int64> numChannelSamples { 0 }; // Grows unbounded while no editor is taking
+    
+    float lastInputRms = 0.0f;  // Message thread only
+    float lastOutputRms = 0.0f;
+};
+
+//==============================================================================
+/**
+    Vertical meter with a cached background. Level meters draw an RMS bar with
+    a peak line; the gain-reduction style draws a bar hanging from the top.
+*/
+class LevelMeter : public juce::Component
+{
+public:
+    enum class Style { level, gainReduction };
+
+    explicit LevelMeter(Style meterStyle);
+
+    // Feeds the latest linear values and applies ballistics; only repaints
+    // this meter, and only if the drawn bars actually moved.
+    void update(float peakGain, float rmsGain, double elapsedSeconds);
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+private:
+    float dbToY(float db) const;
+    void renderBackground();
+
+    Style style;
+    float minDb, maxDb;
+
+    float displayedPeakDb;
+    float displayedRmsDb;
+    int drawnPeakY = -1;
+    int drawnRmsY = -1;
+
+    juce::Image background;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelMeter)
+};
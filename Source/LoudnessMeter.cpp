@@ -0,0 +1,342 @@
+/*
+  ==============================================================================
+
+    LoudnessMeter.cpp
+
+  ==============================================================================
+*/
+
+#include "LoudnessMeter.h"
+
+//==============================================================================
+void LoudnessMeter::prepare(double sampleRate, int numChannels, int maxBlockSize)
+{
+    constexpr auto pi = juce::MathConstants<double>::pi;
+
+    // K-weighting (BS.1770-4), derived for any sample rate as in libebur128:
+    // a high shelf modelling the head, then an RLB high-pass
+    {
+        const double f0 = 1681.974450955533, gainDb = 3.999843853973347, q = 0.7071752369554196;
+        auto k = std::tan(pi * f0 / sampleRate);
+        auto vh = std::pow(10.0, gainDb / 20.0);
+        auto vb = std::pow(vh, 0.4996667741545416);
+        auto a0 = 1.0 + k / q + k * k;
+
+        shelf.b0 = (vh + vb * k / q + k * k) / a0;
+        shelf.b1 = 2.0 * (k * k - vh) / a0;
+        shelf.b2 = (vh - vb * k / q + k * k) / a0;
+        shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+        shelf.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    {
+        const double f0 = 38.13547087602444, q = 0.5003270373238773;
+        auto k = std::tan(pi * f0 / sampleRate);
+        auto a0 = 1.0 + k / q + k * k;
+
+        highPass.b0 = 1.0;
+        highPass.b1 = -2.0;
+        highPass.b2 = 1.0;
+        highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+        highPass.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    // 4x polyphase interpolator: a Blackman-windowed sinc split into phases
+    {
+        constexpr int numTaps = oversampling * tapsPerPhase;
+        std::array<double, numTaps> taps;
+        double sum = 0.0;
+
+        for (int i = 0; i < numTaps; ++i)
+        {
+            auto t = (i - (numTaps - 1) * 0.5) / oversampling;
+            auto sinc = t == 0.0 ? 1.0 : std::sin(pi * t) / (pi * t);
+            auto window = 0.42 - 0.5 * std::cos(2.0 * pi * i / (numTaps - 1)) + 0.08 * std::cos(4.0 * pi * i / (numTaps - 1));
+            taps[(size_t) i] = sinc * window;
+            sum += taps[(size_t) i];
+        }
+
+        for (int i = 0; i < numTaps; ++i)
+            truePeakPhases[(size_t) (i % oversampling)][(size_t) (i / oversampling)] = (float) (taps[(size_t) i] * oversampling / sum);
+    }
+
+    maxSamplesPerCall = maxBlockSize;
+    phaseOutput.assign((size_t) maxBlockSize, 0.0f);
+
+    channels.resize((size_t) numChannels);
+
+    for (auto& state : channels)
+        state.truePeakHistory.assign((size_t) (tapsPerPhase - 1 + maxBlockSize), 0.0f);
+
+    stepSamples = juce::jmax(1, juce::roundToInt(sampleRate * 0.1));
+    stepPosition = 0;
+    stepSum = 0.0;
+
+    stepEnergies.fill(0.0);
+    stepRingPosition = 0;
+    numSteps = 0;
+    momentarySum = shortTermSum = 0.0;
+
+    clearGating();
+    resetRequested.store(false, std::memory_order_relaxed);
+    momentaryLufs.store(silenceLufs, std::memory_order_relaxed);
+    shortTermLufs.store(silenceLufs, std::memory_order_relaxed);
+}
+
+void LoudnessMeter::process(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    jassert(numSamples <= maxSamplesPerCall);
+
+    if (resetRequested.exchange(false, std::memory_order_relaxed))
+        clearGating();
+
+    auto numChannels = juce::jmin(buffer.getNumChannels(), (int) channels.size());
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        truePeak = juce::jmax(truePeak, measureTruePeak(channels[(size_t) channel], buffer.getReadPointer(channel, startSample), numSamples));
+
+    truePeakDb.store(juce::Decibels::gainToDecibels(truePeak, silenceLufs), std::memory_order_relaxed);
+
+    // Filter in segments that end on 100ms step boundaries
+    for (int done = 0; done < numSamples;)
+    {
+        auto segment = juce::jmin(numSamples - done, stepSamples - stepPosition);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto& state = channels[(size_t) channel];
+            auto* samples = buffer.getReadPointer(channel, startSample + done);
+            double sum = 0.0;
+
+            for (int i = 0; i < segment; ++i)
+            {
+                // Transposed direct form II, both stages. NaN or Inf would stay in the
+                // filter state for good, so they're measured as silence.
+                double x = std::isfinite(samples[i]) ? (double) samples[i] : 0.0;
+                double y = shelf.b0 * x + state.shelfZ1;
+                state.shelfZ1 = shelf.b1 * x - shelf.a1 * y + state.shelfZ2;
+                state.shelfZ2 = shelf.b2 * x - shelf.a2 * y;
+
+                double z = highPass.b0 * y + state.highPassZ1;
+                state.highPassZ1 = highPass.b1 * y - highPass.a1 * z + state.highPassZ2;
+                state.highPassZ2 = highPass.b2 * y - highPass.a2 * z;
+
+                sum += z * z;
+            }
+
+            stepSum += sum; // Channel weights are 1.0 for mono/stereo
+        }
+
+        done += segment;
+        stepPosition += segment;
+
+        if (stepPosition == stepSamples)
+            completeStep();
+    }
+}
+
+LoudnessMeter::Readings LoudnessMeter::getReadings() const noexcept
+{
+    Readings readings;
+    readings.momentaryLufs = momentaryLufs.load(std::memory_order_relaxed);
+    readings.shortTermLufs = shortTermLufs.load(std::memory_order_relaxed);
+    readings.integratedLufs = integratedLufs.load(std::memory_order_relaxed);
+    readings.loudnessRangeLu = loudnessRangeLu.load(std::memory_order_relaxed);
+    readings.truePeakDb = truePeakDb.load(std::memory_order_relaxed);
+    return readings;
+}
+
+//==============================================================================
+void LoudnessMeter::clearGating()
+{
+    momentaryGating.clear();
+    shortTermGating.clear();
+    truePeak = 0.0f;
+
+    // A reset also starts the K-weighting from rest
+    for (auto& state : channels)
+        state.shelfZ1 = state.shelfZ2 = state.highPassZ1 = state.highPassZ2 = 0.0;
+
+    integratedLufs.store(silenceLufs, std::memory_order_relaxed);
+    loudnessRangeLu.store(0.0f, std::memory_order_relaxed);
+    truePeakDb.store(silenceLufs, std::memory_order_relaxed);
+}
+
+// Called every 100ms of audio. Everything here is O(1) in programme length:
+// the windows are running sums and the gates walk a fixed number of bins.
+void LoudnessMeter::completeStep()
+{
+    auto stepEnergy = stepSum / stepSamples;
+    stepSum = 0.0;
+    stepPosition = 0;
+
+    if (numSteps >= stepsPerMomentary)
+        momentarySum -= stepEnergies[(size_t) ((stepRingPosition + stepsPerShortTerm - stepsPerMomentary) % stepsPerShortTerm)];
+
+    if (numSteps >= stepsPerShortTerm)
+        shortTermSum -= stepEnergies[(size_t) stepRingPosition];
+
+    stepEnergies[(size_t) stepRingPosition] = stepEnergy;
+    stepRingPosition = (stepRingPosition + 1) % stepsPerShortTerm;
+    momentarySum += stepEnergy;
+    shortTermSum += stepEnergy;
+    ++numSteps;
+
+    // Re-sum exactly once per lap so rounding in the running sums can't accumulate
+    if (stepRingPosition == 0)
+    {
+        momentarySum = shortTermSum = 0.0;
+
+        for (int i = 0; i < stepsPerShortTerm; ++i)
+        {
+            shortTermSum += stepEnergies[(size_t) i];
+
+            if (i >= stepsPerShortTerm - stepsPerMomentary)
+                momentarySum += stepEnergies[(size_t) i];
+        }
+    }
+
+    if (numSteps >= stepsPerMomentary)
+    {
+        auto energy = juce::jmax(0.0, momentarySum / stepsPerMomentary);
+        auto lufs = energyToLufs(energy);
+        momentaryLufs.store(lufs, std::memory_order_relaxed);
+        momentaryGating.add(energy, lufs);
+
+        // Integrated: mean of the blocks above the relative gate (-10 LU)
+        auto& gating = momentaryGating;
+
+        if (gating.totalCount > 0)
+        {
+            auto gateBin = gating.binForLufs(energyToLufs(gating.totalEnergy / (double) gating.totalCount) - 10.0f);
+            double gatedEnergy = 0.0;
+            juce::uint64 gatedCount = 0;
+
+            for (int bin = gateBin; bin < numHistogramBins; ++bin)
+            {
+                gatedEnergy += gating.energy[(size_t) bin];
+                gatedCount += gating.count[(size_t) bin];
+            }
+
+            if (gatedCount > 0)
+                integratedLufs.store(energyToLufs(gatedEnergy / (double) gatedCount), std::memory_order_relaxed);
+        }
+    }
+
+    if (numSteps >= stepsPerShortTerm)
+    {
+        auto energy = juce::jmax(0.0, shortTermSum / stepsPerShortTerm);
+        auto lufs = energyToLufs(energy);
+        shortTermLufs.store(lufs, std::memory_order_relaxed);
+        shortTermGating.add(energy, lufs);
+
+        // LRA (EBU Tech 3342): 10th to 95th percentile above the -20 LU relative gate
+        auto& gating = shortTermGating;
+
+        if (gating.totalCount > 0)
+        {
+            auto gateBin = gating.binForLufs(energyToLufs(gating.totalEnergy / (double) gating.totalCount) - 20.0f);
+            juce::uint64 gatedCount = 0;
+
+            for (int bin = gateBin; bin < numHistogramBins; ++bin)
+                gatedCount += gating.count[(size_t) bin];
+
+            if (gatedCount > 0)
+            {
+                auto lowTarget = (juce::uint64) std::ceil(0.10 * (double) gatedCount);
+                auto highTarget = (juce::uint64) std::ceil(0.95 * (double) gatedCount);
+                int lowBin = gateBin, highBin = gateBin;
+                juce::uint64 cumulative = 0;
+
+                for (int bin = gateBin; bin < numHistogramBins; ++bin)
+                {
+                    auto previous = cumulative;
+                    cumulative += gating.count[(size_t) bin];
+
+                    if (previous < lowTarget && cumulative >= lowTarget)
+                        lowBin = bin;
+
+                    if (previous < highTarget && cumulative >= highTarget)
+                    {
+                        highBin = bin;
+                        break;
+                    }
+                }
+
+                loudnessRangeLu.store((float) (highBin - lowBin) / (float) binsPerLu, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+// Each polyphase branch is applied as a handful of SIMD multiply-adds over the
+// whole block rather than a per-sample dot product.
+float LoudnessMeter::measureTruePeak(ChannelState& state, const float* samples, int numSamples) noexcept
+{
+    constexpr int historyLength = tapsPerPhase - 1;
+    auto* history = state.truePeakHistory.data();
+    auto* output = phaseOutput.data();
+
+    juce::FloatVectorOperations::copy(history + historyLength, samples, numSamples);
+
+    // As in the loudness filters, NaN and Inf count as silence rather than
+    // pinning the peak or staying in the history
+    for (int i = historyLength; i < historyLength + numSamples; ++i)
+        if (! std::isfinite(history[i]))
+            history[i] = 0.0f;
+
+    float peak = 0.0f;
+
+    for (const auto& phase : truePeakPhases)
+    {
+        juce::FloatVectorOperations::clear(output, numSamples);
+
+        for (int tap = 0; tap < tapsPerPhase; ++tap)
+            juce::FloatVectorOperations::addWithMultiply(output, history + historyLength - tap, phase[(size_t) tap], numSamples);
+
+        auto range = juce::FloatVectorOperations::findMinAndMax(output, numSamples);
+        peak = juce::jmax(peak, -range.getStart(), range.getEnd());
+    }
+
+    // Keep the tail for the next block's filter history
+    std::memmove(history, history + numSamples, sizeof(float) * (size_t) historyLength);
+
+    return peak;
+}
+
+float LoudnessMeter::energyToLufs(double energy)
+{
+    return energy > 0.0 ? (float) (-0.691 + 10.0 * std::log10(energy)) : silenceLufs;
+}
+
+//==============================================================================
+void LoudnessMeter::GatingHistogram::clear()
+{
+    energy.fill(0.0);
+    count.fill(0);
+    totalEnergy = 0.0;
+    totalCount = 0;
+}
+
+void LoudnessMeter::GatingHistogram::add(double blockEnergy, float blockLufs)
+{
+    if (! (blockLufs >= histogramMinLufs)) // Also NaN
+        return;
+
+    auto bin = binForLufs(blockLufs);
+    energy[(size_t) bin] += blockEnergy;
+    ++count[(size_t) bin];
+    totalEnergy += blockEnergy;
+    ++totalCount;
+}
+
+int LoudnessMeter::GatingHistogram::binForLufs(float lufs) const
+{
+    // Clamped as a float: converting NaN or an out-of-range value to int is undefined
+    auto bin = std::floor((lufs - histogramMinLufs) * (float) binsPerLu);
+
+    if (! (bin > 0.0f)) // Also NaN
+        return 0;
+
+    return (int) juce::jmin(bin, (float) (numHistogramBins - 1));
+}
@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    LoudnessMeter.h
+    EBU R128 / ITU-R BS.1770 loudness of the plugin's output: momentary,
+    short-term, integrated, loudness range and 4x oversampled true peak.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Runs on the audio thread with bounded cost per sample. Block energies are
+    kept in running sums and the gating uses fixed-bin histograms, so integrated
+    loudness and LRA never rescan the programme history.
+*/
+class LoudnessMeter
+{
+public:
+    static constexpr float silenceLufs = -100.0f;
+
+    struct Readings
+    {
+        float momentaryLufs = silenceLufs;
+        float shortTermLufs = silenceLufs;
+        float integratedLufs = silenceLufs;
+        float loudnessRangeLu = 0.0f;
+        float truePeakDb = silenceLufs;
+    };
+
+    LoudnessMeter() = default;
+
+    // Allocates everything process() needs; maxBlockSize bounds each call
+    void prepare(double sampleRate, int numChannels, int maxBlockSize);
+
+    // Audio thread
+    void process(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+    // Any thread
+    Readings getReadings() const noexcept;
+
+    // Any thread; integrated, LRA and true peak restart from the next block, with
+    // the K-weighting filters at rest
+    void resetIntegrated() noexcept { resetRequested.store(true, std::memory_order_relaxed); }
+
+private:
+    static constexpr int stepsPerMomentary = 4;    // 400ms of 100ms steps
+    static constexpr int stepsPerShortTerm = 30;   // 3s of 100ms steps
+    static constexpr float histogramMinLufs = -70.0f; // Absolute gate
+    static constexpr int binsPerLu = 10;
+    static constexpr int numHistogramBins = 80 * binsPerLu; // -70 to +10 LUFS
+
+    static constexpr int oversampling = 4;
+    static constexpr int tapsPerPhase = 12;
+
+    struct Biquad
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    };
+
+    struct ChannelState
+    {
+        double shelfZ1 = 0.0, shelfZ2 = 0.0;
+        double highPassZ1 = 0.0, highPassZ2 = 0.0;
+        std::vector<float> truePeakHistory; // tapsPerPhase - 1 previous samples, then the block
+    };
+
+    struct GatingHistogram
+    {
+        std::array<double, numHistogramBins> energy {};
+        std::array<juce::uint32, numHistogramBins> count {};
+        double totalEnergy = 0.0;
+        juce::uint64 totalCount = 0;
+
+        void clear();
+        void add(double blockEnergy, float blockLufs);
+        int binForLufs(float lufs) const;
+    };
+
+    void clearGating();
+    void completeStep();
+    float measureTruePeak(ChannelState& state, const float* samples, int numSamples) noexcept;
+
+    static float energyToLufs(double energy);
+
+    Biquad shelf, highPass;
+    std::vector<ChannelState> channels;
+    std::array<std::array<float, tapsPerPhase>, oversampling> truePeakPhases {};
+    std::vector<float> phaseOutput;
+    int maxSamplesPerCall = 0;
+
+    int stepSamples = 4410;
+    int stepPosition = 0;
+    double stepSum = 0.0;
+
+    std::array<double, stepsPerShortTerm> stepEnergies {};
+    int stepRingPosition = 0;
+    juce::uint64 numSteps = 0;
+    double momentarySum = 0.0;
+    double shortTermSum = 0.0;
+
+    GatingHistogram momentaryGating;  // 400ms blocks, 75% overlap -> integrated
+    GatingHistogram shortTermGating;  // 3s blocks every 100ms -> LRA
+    float truePeak = 0.0f;
+
+    std::atomic<float> momentaryLufs { silenceLufs };
+    std::atomic<float> shortTermLufs { silenceLufs };
+    std::atomic<float> integratedLufs { silenceLufs };
+    std::atomic<float> loudnessRangeLu { 0.0f };
+    std::atomic<float> truePeakDb { silenceLufs };
+    std::atomic<bool> resetRequested { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoudnessMeter)
+};
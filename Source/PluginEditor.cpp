@@ -39,10 +39,31 @@ Squeeze1AudioProcessorEditor::Squeeze1AudioProcessorEditor (Squeeze1AudioProcess
     
     gainAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.apvts, "GAIN", gainKnob);
     
+    // Small toggles beside the Ratio and Release labels
+    for ( auto* button : { &feedbackButton, &autoReleaseButton } ) {
+        button->setClickingTogglesState(true);
+        button->setColour(juce::TextButton::buttonColourId, juce::Colours::black);
+        button->setColour(juce::TextButton::buttonOnColourId, juce::Colours::orange);
+        button->onClick = [this] { requestResponsePreview(); };
+        addAndMakeVisible(button);
+    }
+    
+    topologyAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.apvts, "TOPOLOGY", feedbackButton);
+    
+    autoReleaseAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.apvts, "AUTO_RELEASE", autoReleaseButton);
+    
     addAndMakeVisible(inputWaveform);
     addAndMakeVisible(outputWaveform);
     
-    setSize (600, 400);
+    addAndMakeVisible(inputMeter);
+    addAndMakeVisible(outputMeter);
+    addAndMakeVisible(gainReductionMeter);
+    
+    addChildComponent(spectrumView);
+    
+    responsePreview.addChangeListener(this);
+    
+    setSize (600, 420);
     startTimerHz(30);
     drawInputWaveform = true;
 }
@@ -54,18 +75,24 @@ Squeeze1AudioProcessorEditor::~Squeeze1AudioProcessorEditor()
         knob->removeListener(this);
     }
     
+    responsePreview.removeChangeListener(this);
     juce::LookAndFeel::setDefaultLookAndFeel(nullptr);
 }
 
 //==============================================================================
 void Squeeze1AudioProcessorEditor::paint (juce::Graphics& g)
 {
+    SQUEEZE1_TRACE_SCOPE("paint");
+    
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (juce::Colours::white);
     //drawRects(g); Draw bounding rectangles
     
     drawStaticWindows(g);
     drawLabels(g);
+    drawDspLoad(g);
+    drawTelemetry(g);
+    drawLoudness(g);
     
     if ( drawInputWaveform ) {
         drawWaveform(g, audioProcessor.getInputBuffer(), inputWindow, juce::Colours::white);
@@ -77,7 +104,10 @@ void Squeeze1AudioProcessorEditor::paint (juce::Graphics& g)
     }
     
     
-    drawWaveform(g, audioProcessor.getOutputBuffer(), outputWindow, juce::Colours::orange);
+    // Otherwise the spectrum view covers the output window
+    if ( ! showSpectrum ) {
+        drawWaveform(g, audioProcessor.getOutputBuffer(), outputWindow, juce::Colours::orange);
+    }
     
     if ( isEnvelopeVisible ) {
         drawEnvelope(g, outputWindow.toNearestInt());
@@ -90,9 +120,12 @@ void Squeeze1AudioProcessorEditor::resized()
    //======================= Rectangles ================================
     auto bounds = getLocalBounds().toFloat();
     
+    loudnessRect = bounds.removeFromBottom(20.f).reduced(bounds.getWidth() * 0.08f, 0);
     
     topRect = bounds.removeFromTop(bounds.getHeight() * 0.67);
     
+    meterRect = topRect.removeFromRight(topRect.getWidth() * 0.1);
+    
     inputRect = topRect.removeFromLeft(topRect.getWidth() * 0.5);
     outputRect = topRect;
     
@@ -103,6 +136,9 @@ void Squeeze1AudioProcessorEditor::resized()
     outputWindow = outputRect.reduced(outputRect.getWidth() * 0.05, outputRect.getHeight() * 0.05);
     outputLabel = outputWindow.removeFromTop(20.f);
     
+    // Thin strip above the windows for the diagnostics readouts
+    statusRect = { inputLabel.getX(), 0.f, outputLabel.getRight() - inputLabel.getX(), inputLabel.getY() };
+    
     
     bottomRect = bounds;
     auto temp = bottomRect;
@@ -143,6 +179,18 @@ void Squeeze1AudioProcessorEditor::resized()
     
     bottomRect = temp;
     
+    //======================= Meters ================================
+    
+    meterRect = meterRect.withTrimmedRight(meterRect.getWidth() * 0.1)
+                         .withTop(outputLabel.getY()).withBottom(outputWindow.getBottom());
+    meterLabel = meterRect.removeFromTop(20.f);
+    
+    auto meterArea = meterRect;
+    auto meterWidth = meterArea.getWidth() / 3;
+    inputMeter.setBounds(meterArea.removeFromLeft(meterWidth).reduced(2.f, 0).toNearestInt());
+    outputMeter.setBounds(meterArea.removeFromLeft(meterWidth).reduced(2.f, 0).toNearestInt());
+    gainReductionMeter.setBounds(meterArea.reduced(2.f, 0).toNearestInt());
+    
     //======================= Sliders/Knobs ================================
     
     thresholdKnob.setBounds(threshRect.toNearestInt());
@@ -150,6 +198,13 @@ void Squeeze1AudioProcessorEditor::resized()
     attackKnob.setBounds(attackRect.toNearestInt());
     releaseKnob.setBounds(releaseRect.toNearestInt());
     gainKnob.setBounds(gainRect.toNearestInt());
+    
+    feedbackButton.setBounds(ratioLabel.withLeft(ratioLabel.getRight() - 36.f).reduced(2.f).toNearestInt());
+    autoReleaseButton.setBounds(releaseLabel.withLeft(releaseLabel.getRight() - 36.f).reduced(2.f).toNearestInt());
+    
+    spectrumView.setBounds(outputWindow.toNearestInt());
+    
+    requestResponsePreview();
 
 }
 
@@ -159,6 +214,8 @@ void Squeeze1AudioProcessorEditor::resized()
 
 void Squeeze1AudioProcessorEditor::drawWaveform(juce::Graphics& g, const juce::AudioBuffer<float>& buffer, juce::Rectangle<float> bounds, juce::Colour colour)
 {
+    SQUEEZE1_TRACE_SCOPE("drawWaveform");
+    
     g.setColour(colour);
     
     // Center the waveform vertically
@@ -237,6 +294,7 @@ void Squeeze1AudioProcessorEditor::drawLabels(juce::Graphics& g) {
     g.setColour(juce::Colours::darkslategrey);
     g.drawFittedText("Input", inputLabel.toNearestInt(), juce::Justification::centred, 1);
     g.drawFittedText("Output", outputLabel.toNearestInt(), juce::Justification::centred, 1);
+    g.drawFittedText("I/O/GR", meterLabel.toNearestInt(), juce::Justification::centred, 1);
     
     g.drawFittedText("Threshold", threshLabel.toNearestInt(), juce::Justification::centredBottom, 1);
     g.drawFittedText("Ratio", ratioLabel.toNearestInt(), juce::Justification::centredBottom, 1);
@@ -250,3 +308,45 @@ void Squeeze1AudioProcessorEditor::drawLabels(juce::Graphics& g) {
     g.drawFittedText("0ms | 1s", releaseRange.toNearestInt(), juce::Justification::centredTop, 1);
     g.drawFittedText("0dB | 24dB", gainRange.toNearestInt(), juce::Justification::centredTop, 1);
 }
+
+void Squeeze1AudioProcessorEditor::drawDspLoad(juce::Graphics& g) {
+    juce::String text;
+    text << "DSP " << juce::String(audioProcessor.getDspLoad() * 100.0, 1) << "% | "
+         << juce::String(audioProcessor.getWorstBlockMs(), 2) << "ms";
+    
+    g.setColour(audioProcessor.getXRunCount() > 0 ? juce::Colours::red : juce::Colours::darkslategrey);
+    g.setFont(11.0f);
+    g.drawFittedText(text, statusRect.toNearestInt(), juce::Justification::centredRight, 1);
+}
+
+void Squeeze1AudioProcessorEditor::drawTelemetry(juce::Graphics& g) {
+    auto snapshot = audioProcessor.getTelemetry().getSnapshot();
+    
+    juce::String text;
+    text << "Active " << juce::roundToInt(snapshot.getFractionOverThreshold() * 100.0) << "% | "
+         << "Peak GR " << juce::String(snapshot.peakGainReductionDb, 1) << "dB | "
+         << "p99 " << juce::String(snapshot.getBlockTimePercentileMs(99.0), 2) << "ms";
+    
+    g.setColour(juce::Colours::darkslategrey);
+    g.setFont(11.0f);
+    g.drawFittedText(text, statusRect.toNearestInt(), juce::Justification::centredLeft, 1);
+}
+
+void Squeeze1AudioProcessorEditor::drawLoudness(juce::Graphics& g) {
+    auto readings = audioProcessor.getLoudnessMeter().getReadings();
+    
+    auto format = [] (float lufs) {
+        return lufs > -70.0f ? juce::String(lufs, 1) : juce::String("--");
+    };
+    
+    juce::String text;
+    text << "M " << format(readings.momentaryLufs)
+         << "  S " << format(readings.shortTermLufs)
+         << "  I " << format(readings.integratedLufs) << " LUFS"
+         << "  LRA " << juce::String(readings.loudnessRangeLu, 1) << " LU"
+         << "  TP " << format(readings.truePeakDb) << " dBTP";
+    
+    g.setColour(readings.truePeakDb > -1.0f ? juce::Colours::red : juce::Colours::darkslategrey);
+    g.setFont(12.0f);
+    g.drawFittedText(text, loudnessRect.toNearestInt(), juce::Justification::centred, 1);
+}
@@ -10,6 +10,7 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "ResponsePreview.h"
 
 //==============================================================================
 
@@ -149,6 +150,7 @@ private:
 */
 class Squeeze1AudioProcessorEditor  : public juce::AudioProcessorEditor,
                                       private juce::Timer,
+                                      private juce::ChangeListener,
                                       public juce::Slider::Listener
 {
 public:
@@ -169,6 +171,7 @@ public:
             if (slider == &thresholdKnob || slider == &attackKnob || slider == &releaseKnob || slider == &ratioKnob)
             {
                 isEnvelopeVisible = true;
+                requestResponsePreview(); // Simulated off the message thread
                 repaint(); // Redraw to show the envelope
             }
         }
@@ -184,70 +187,97 @@ public:
     
     void timerCallback() override
     {
+        SQUEEZE1_TRACE_SCOPE("timerCallback");
+        
+        // The coefficients depend on the rate, which the host can change while we're open
+        if (audioProcessor.getSampleRate() != previewSampleRate)
+            requestResponsePreview();
+        
         inputWaveform.setBuffer(&audioProcessor.getInputBuffer());
         outputWaveform.setBuffer(&audioProcessor.getOutputBuffer());
-        repaint();
+        
+        auto levels = audioProcessor.getMeterSource().take();
+        auto elapsedSeconds = getTimerInterval() / 1000.0;
+        inputMeter.update(levels.inputPeak, levels.inputRms, elapsedSeconds);
+        outputMeter.update(levels.outputPeak, levels.outputRms, elapsedSeconds);
+        gainReductionMeter.update(levels.gain, levels.gain, elapsedSeconds);
+        
+        // Only the regions that change every frame; the meters repaint themselves
+        repaint(statusRect.getSmallestIntegerContainer());
+        repaint(loudnessRect.getSmallestIntegerContainer());
+        repaint(inputWindow.expanded(windowSill).getSmallestIntegerContainer());
+        repaint(outputWindow.expanded(windowSill).getSmallestIntegerContainer());
     }
     
     void drawWaveform(juce::Graphics& g, const juce::AudioBuffer<float>& buffer, juce::Rectangle<float> bounds, juce::Colour colour);
     
+    // Blits the preview rendered by the background thread; nothing is computed here
     void drawEnvelope(juce::Graphics& g, const juce::Rectangle<int>& bounds)
     {
-        juce::Path envelopePath;
-
-        float midY = bounds.getCentreY();
-
-            // Get slider values
-            float threshold = thresholdKnob.getValue(); // dB
-            float attack = attackKnob.getValue();       // ms
-            float release = releaseKnob.getValue();     // ms
-            float ratio = ratioKnob.getValue();         // ratio
-
-        // Scale attack and release times relative to the bounds width
-            float totalWidth = static_cast<float>(bounds.getWidth());
-            float attackTime = juce::jmap(attack, 0.0f, 100.0f, 0.0f, totalWidth * 0.5f);
-            float releaseTime = juce::jmap(release, 0.0f, 1000.0f, 0.0f, totalWidth * 0.5f);
-
-            // Normalize threshold height
-            float thresholdHeight = juce::jmap(threshold, -30.0f, 0.0f, midY, (float)bounds.getY());
-
-            // Constrain threshold height to stay within bounds
-            thresholdHeight = juce::jlimit<float>(bounds.getY(), midY, thresholdHeight);
-
-            // Calculate compressed height based on ratio
-            float compressedHeight = juce::jmap(ratio, 1.0f, 20.0f, thresholdHeight, midY);
-
-            // Start the envelope at the midpoint (left side of the bounds)
-            envelopePath.startNewSubPath(bounds.getX(), midY);
-
-            // Attack: Line from the midpoint to the threshold height
-            envelopePath.lineTo(bounds.getX() + attackTime, thresholdHeight);
-
-            // Sustain: Line across the compressed height
-            envelopePath.lineTo(bounds.getX() + attackTime + (totalWidth - attackTime - releaseTime), compressedHeight);
-
-            // Release: Line from compressed height back to midpoint
-            envelopePath.lineTo(bounds.getRight(), midY);
-
-        // Reflect the path below the midpoint
-        juce::Path mirroredPath;
-        mirroredPath.addPath(envelopePath, juce::AffineTransform::scale(1.0f, -1.0f, bounds.getX(), midY));
-
-        // Draw the envelope
-        g.setColour(juce::Colours::lightskyblue);
-        g.strokePath(envelopePath, juce::PathStrokeType(1.0f));
-        g.setColour(juce::Colours::violet);
-        g.strokePath(mirroredPath, juce::PathStrokeType(1.0f));
+        SQUEEZE1_TRACE_SCOPE("drawEnvelope");
+        
+        auto image = responsePreview.getImage();
+        
+        if (image.isValid())
+            g.drawImage(image, bounds.toFloat(), juce::RectanglePlacement::stretchToFit);
+    }
+    
+    void requestResponsePreview()
+    {
+        // Before prepareToPlay the rate is 0, which would make every coefficient 1
+        previewSampleRate = audioProcessor.getSampleRate();
+        auto sampleRate = previewSampleRate > 0.0 ? previewSampleRate : 44100.0;
+        
+        auto settings = Squeeze1AudioProcessor::makeSettings((float) thresholdKnob.getValue(), (float) ratioKnob.getValue(),
+                                                             (float) attackKnob.getValue(), (float) releaseKnob.getValue(),
+                                                             (float) gainKnob.getValue(), sampleRate,
+                                                             feedbackButton.getToggleState(), autoReleaseButton.getToggleState());
+        
+        auto bounds = outputWindow.toNearestInt();
+        responsePreview.requestRender(settings, sampleRate, bounds.getWidth(), bounds.getHeight());
+    }
+    
+    void changeListenerCallback(juce::ChangeBroadcaster*) override
+    {
+        if (isEnvelopeVisible)
+            repaint(outputWindow.expanded(windowSill).getSmallestIntegerContainer());
     }
 
     
     void mouseDown(const juce::MouseEvent& event) override
         {
+           #if SQUEEZE1_ENABLE_TRACING
+            // Right-click dumps the trace buffers for chrome://tracing / Perfetto
+            if (event.mods.isPopupMenu())
+            {
+                TraceEvents::writeChromeJson(juce::File::getSpecialLocation(juce::File::userDesktopDirectory)
+                                                 .getChildFile("Squeeze1Trace.json"));
+                return;
+            }
+           #endif
+            
             if (inputWindow.contains(event.getPosition().toFloat()))
             {
                 drawInputWaveform = !drawInputWaveform;
                 repaint(); 
             }
+            else if (loudnessRect.contains(event.getPosition().toFloat()))
+            {
+                audioProcessor.getLoudnessMeter().resetIntegrated();
+            }
+            else if (outputWindow.contains(event.getPosition().toFloat()))
+            {
+                showSpectrum = !showSpectrum;
+                
+                // Only pay for the capture and FFTs while the spectrum is on screen
+                if (showSpectrum)
+                    spectrumAnalyzer.start();
+                else
+                    spectrumAnalyzer.stop();
+                
+                spectrumView.setVisible(showSpectrum);
+                repaint();
+            }
         }
 
 private:
@@ -258,17 +288,29 @@ private:
     
     
     bool isEnvelopeVisible = false;
+    double previewSampleRate = 0.0; // The processor's rate when the preview was last requested
     bool drawInputWaveform;
+    bool showSpectrum = false;
 
     WaveformComponent inputWaveform;
     WaveformComponent outputWaveform;
     
+    LevelMeter inputMeter { LevelMeter::Style::level };
+    LevelMeter outputMeter { LevelMeter::Style::level };
+    LevelMeter gainReductionMeter { LevelMeter::Style::gainReduction };
+    
+    SpectrumAnalyzer spectrumAnalyzer { audioProcessor.getSpectrumCapture() };
+    SpectrumComponent spectrumView { spectrumAnalyzer };
+    
     juce::Slider thresholdKnob;
     juce::Slider ratioKnob;
     juce::Slider attackKnob;
     juce::Slider releaseKnob;
     juce::Slider gainKnob;
     
+    juce::TextButton feedbackButton { "FB" };
+    juce::TextButton autoReleaseButton { "AUTO" };
+    
     
     
     using Attachment = juce::AudioProcessorValueTreeState::SliderAttachment;
@@ -278,8 +320,13 @@ private:
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> releaseAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> gainAttachment;
     
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> topologyAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> autoReleaseAttachment;
+    
     CustomLookAndFeel customLookAndFeel;
     
+    ResponsePreview responsePreview;
+    
     GlobalLookAndFeel globalLookAndFeel;
 
     //==============================================================================
@@ -288,7 +335,12 @@ private:
     void drawRects(juce::Graphics& g); //for debugging
     void drawStaticWindows(juce::Graphics& g);
     void drawLabels(juce::Graphics& g);
+    void drawDspLoad(juce::Graphics& g);
+    void drawTelemetry(juce::Graphics& g);
+    void drawLoudness(juce::Graphics& g);
     
+    juce::Rectangle<float> statusRect;
+    juce::Rectangle<float> loudnessRect;
     juce::Rectangle<float> topRect;
         juce::Rectangle<float> inputRect;
             juce::Rectangle<float> inputLabel;
@@ -298,6 +350,8 @@ private:
             juce::Rectangle<float> outputLabel;
             juce::Rectangle<float> outputWindow; //(rounded)
                 juce::Line<float> outputZero;
+        juce::Rectangle<float> meterRect;
+            juce::Rectangle<float> meterLabel;
     
     juce::Rectangle<float> bottomRect;
         juce::Rectangle<float> threshRect;
@@ -9,6 +9,23 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+//==============================================================================
+namespace
+{
+    void accumulateLevel(const float* data, int numSamples, float& peak, double& sumOfSquares)
+    {
+        auto range = juce::FloatVectorOperations::findMinAndMax(data, numSamples);
+        peak = juce::jmax(peak, -range.getStart(), range.getEnd());
+        
+        float chunkSum = 0.0f;
+        
+        for (int i = 0; i < numSamples; ++i)
+            chunkSum += data[i] * data[i];
+        
+        sumOfSquares += chunkSum;
+    }
+}
+
 //==============================================================================
 Squeeze1AudioProcessor::Squeeze1AudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -19,8 +36,7 @@ Squeeze1AudioProcessor::Squeeze1AudioProcessor()
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
-                       ),
-            envelope(0.0f)
+                       )
 #endif
 {
     
@@ -57,6 +73,13 @@ juce::AudioProcessorValueTreeState::ParameterLayout Squeeze1AudioProcessor::crea
     params.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{"GAIN", 1}, "Gain",
                                                                  juce::NormalisableRange<float>(0.0f, 24.0f, 0.1f), 0.0f));
     
+    // Detector topology; both follow the same static curve, see CompressorKernel
+    params.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{"TOPOLOGY", 1}, "Topology",
+                                                                 juce::StringArray{"Feed-forward", "Feedback"}, 0));
+    
+    // Program-dependent release
+    params.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{"AUTO_RELEASE", 1}, "Auto Release", false));
+    
     return params;
 }
 
@@ -130,6 +153,18 @@ void Squeeze1AudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlo
     // initialisation that you need..
     inputBuffer.setSize(1, samplesPerBlock); // Mono buffer for input visualization
     outputBuffer.setSize(1, samplesPerBlock);
+    
+    // Per-channel detector state, allocated here so processBlock never has to
+    channelStates.assign((size_t) juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels()), CompressorChannelState());
+    
+    loadMeasurer.reset(sampleRate, samplesPerBlock);
+    worstBlockMs.store(0.0, std::memory_order_relaxed);
+    telemetry.reset();
+    
+    spectrumCapture.setSampleRate(sampleRate);
+    analyzerInput.setSize(1, maxChunkSize);
+    
+    loudnessMeter.prepare(sampleRate, (int) channelStates.size(), maxChunkSize);
 }
 
 void Squeeze1AudioProcessor::releaseResources()
@@ -166,7 +201,11 @@ bool Squeeze1AudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 
 void Squeeze1AudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    SQUEEZE1_TRACE_SCOPE("processBlock");
     juce::ScopedNoDenormals noDenormals;
+    RealtimeSafety::ScopedAudioThread audioThreadCheck; // Aborts on allocations/locks in debug builds
+    
+    auto blockStartTicks = juce::Time::getHighResolutionTicks();
 
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -178,58 +217,87 @@ void Squeeze1AudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
     
     
     auto gainDb = apvts.getRawParameterValue("GAIN")->load();
-    auto linearGain = juce::Decibels::decibelsToGain(gainDb);
-    
     auto thresholdDb = apvts.getRawParameterValue("THRESHOLD")->load();
-    auto linearThreshold = juce::Decibels::decibelsToGain(thresholdDb);
-    
     auto ratio = apvts.getRawParameterValue("RATIO")->load();
-    
     auto attackMs = apvts.getRawParameterValue("ATTACK")->load();
-    auto attackCoeff = calculateAttackCoefficient(attackMs, getSampleRate());
-    
     auto releaseMs = apvts.getRawParameterValue("RELEASE")->load();
-    auto releaseCoeff = calculateReleaseCoefficient(releaseMs, getSampleRate());
+    auto feedback = apvts.getRawParameterValue("TOPOLOGY")->load() > 0.5f;
+    auto autoRelease = apvts.getRawParameterValue("AUTO_RELEASE")->load() > 0.5f;
+    
+    auto settings = makeSettings(thresholdDb, ratio, attackMs, releaseMs, gainDb, getSampleRate(), feedback, autoRelease);
+    CompressorStats stats;
+    
+    // channelStates is sized from the bus layout in prepareToPlay. If a host
+    // sends more channels than that without re-preparing, the extra channels are
+    // passed through unprocessed rather than read past the end of channelStates.
+    auto numSamples = buffer.getNumSamples();
+    jassert((int) channelStates.size() >= juce::jmax(totalNumInputChannels, totalNumOutputChannels));
+    auto numChannels = juce::jmin(buffer.getNumChannels(), (int) channelStates.size());
+    jassert(numChannels == buffer.getNumChannels()); // prepareToPlay wasn't called for this layout
+    
+    // Hosts may send more than samplesPerBlock, so only the most recent
+    // samples that fit are kept for visualization
+    auto numToDisplay = juce::jmin(numSamples, inputBuffer.getNumSamples());
+    auto displayStart = numSamples - numToDisplay;
     
     // Copy input buffer for visualization
-    inputBuffer.copyFrom(0, 0, buffer, 0, 0, buffer.getNumSamples());
+    if (numChannels > 0)
+        inputBuffer.copyFrom(0, 0, buffer, 0, displayStart, numToDisplay);
     
 
-    // Process audio (example gain reduction)
-    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    // Process audio in cache-sized chunks; each channel carries its own
+    // detector state, so the output is identical however the host splits the audio
+    LevelMeterSource::BlockLevels levels;
+    
+    auto captureSpectrum = spectrumCapture.isActive();
+    
+    for (int chunkStart = 0; chunkStart < numSamples; chunkStart += maxChunkSize)
     {
-        auto* channelData = buffer.getWritePointer(channel);
+        auto chunkSize = juce::jmin(maxChunkSize, numSamples - chunkStart);
         
-        for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+        for (int channel = 0; channel < numChannels; ++channel)
         {
-            auto& sampleValue = channelData[sample];
+            auto* channelData = buffer.getWritePointer(channel, chunkStart);
+            
+            // Metered while the chunk is still in cache
+            accumulateLevel(channelData, chunkSize, levels.inputPeak, levels.inputSumOfSquares);
+            
+            if (channel == 0 && captureSpectrum)
+                analyzerInput.copyFrom(0, 0, channelData, chunkSize);
             
+            CompressorKernel::process(channelData, chunkSize, channelStates[(size_t) channel], settings, stats);
+            accumulateLevel(channelData, chunkSize, levels.outputPeak, levels.outputSumOfSquares);
             
-            if (std::abs(sampleValue) > linearThreshold){
-                            // Calculate the excess above the threshold
-                float excess = std::abs(sampleValue) - linearThreshold;
-
-                            // Smooth the gain reduction using the envelope
-                float targetEnvelope = excess / ratio; // Amount of reduction based on ratio
-                envelope = envelope + attackCoeff * (targetEnvelope - envelope); // Attack smoothing
-
-                            // Apply compression
-                float compressedSample = linearThreshold + envelope;
-                sampleValue = (sampleValue > 0.0f ? compressedSample : -compressedSample); // Preserve polarity
-            }
-            else {
-                // Release the envelope
-                envelope = envelope - releaseCoeff * envelope;
-                envelope = juce::jmax(envelope, 0.0f); // Ensure envelope doesn't go negative
-            }
-                // Apply final gain
-                sampleValue *= linearGain;
+            // The audio thread only copies; the FFTs run on the analyzer thread
+            if (channel == 0 && captureSpectrum)
+                spectrumCapture.push(analyzerInput.getReadPointer(0), channelData, chunkSize);
         }
+        
+        loudnessMeter.process(buffer, chunkStart, chunkSize);
+    }
+    
+    if (numSamples > 0 && numChannels > 0)
+    {
+        levels.numChannelSamples = numSamples * numChannels;
+        levels.gain = stats.minGain;
+        meterSource.publish(levels);
     }
    
 
     // Copy output buffer for visualization
-    outputBuffer.copyFrom(0, 0, buffer, 0, 0, buffer.getNumSamples());
+    if (numChannels > 0)
+        outputBuffer.copyFrom(0, 0, buffer, 0, displayStart, numToDisplay);
+    
+    auto blockMs = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - blockStartTicks) * 1000.0;
+    
+    // An empty block has no duration to measure against, and would poison the load with inf/NaN
+    if (numSamples > 0)
+        loadMeasurer.registerRenderTime(blockMs, numSamples);
+    
+    if (blockMs > worstBlockMs.load(std::memory_order_relaxed))
+        worstBlockMs.store(blockMs, std::memory_order_relaxed);
+    
+    telemetry.recordBlock(blockMs, numSamples * numChannels, stats);
 }
 
 //==============================================================================
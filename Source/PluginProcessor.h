@@ -9,6 +9,13 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "CompressorKernel.h"
+#include "RealtimeSafety.h"
+#include "TraceEvents.h"
+#include "BlockTelemetry.h"
+#include "LevelMeter.h"
+#include "SpectrumAnalyzer.h"
+#include "LoudnessMeter.h"
 
 
 //==============================================================================
@@ -62,26 +69,70 @@ public:
     juce::AudioBuffer<float>& getInputBuffer() { return inputBuffer; }
     juce::AudioBuffer<float>& getOutputBuffer() { return outputBuffer; }
     
-    float calculateAttackCoefficient(float attackMs, double sampleRate)
+    // Always-on DSP load figures, safe to read from the message thread
+    double getDspLoad() const { return loadMeasurer.getLoadAsProportion(); }
+    double getWorstBlockMs() const { return worstBlockMs.load(std::memory_order_relaxed); }
+    int getXRunCount() const { return loadMeasurer.getXRunCount(); }
+    
+    // Block timing histogram and compressor activity, filled lock-free by processBlock
+    BlockTelemetry& getTelemetry() { return telemetry; }
+    
+    // Peak/RMS levels and gain reduction for the editor's meters
+    LevelMeterSource& getMeterSource() { return meterSource; }
+    
+    // Input/output samples for the editor's spectrum analyzer
+    SpectrumCapture& getSpectrumCapture() { return spectrumCapture; }
+    
+    // EBU R128 loudness of the output
+    LoudnessMeter& getLoudnessMeter() { return loudnessMeter; }
+    
+    static float calculateAttackCoefficient(float attackMs, double sampleRate)
     {
         float attackTimeInSeconds = attackMs / 1000.0f;
         return 1.0f - std::exp(-1.0f / (attackTimeInSeconds * sampleRate));
     }
     
-    float calculateReleaseCoefficient(float releaseMs, double sampleRate)
+    static float calculateReleaseCoefficient(float releaseMs, double sampleRate)
     {
         float releaseTimeInSeconds = releaseMs / 1000.0f;
         return 1.0f - std::exp(-1.0f / (releaseTimeInSeconds * sampleRate));
     }
+    
+    // Resolves parameter values into what the kernel runs on. Also used off the
+    // audio thread to simulate the DSP for previews.
+    static CompressorSettings makeSettings(float thresholdDb, float ratio, float attackMs,
+                                           float releaseMs, float gainDb, double sampleRate,
+                                           bool feedback = false, bool autoRelease = false)
+    {
+        return { juce::Decibels::decibelsToGain(thresholdDb), ratio,
+                 calculateAttackCoefficient(attackMs, sampleRate),
+                 calculateReleaseCoefficient(releaseMs, sampleRate),
+                 juce::Decibels::decibelsToGain(gainDb),
+                 feedback, autoRelease,
+                 calculateAttackCoefficient(attackMs * CompressorKernel::slowStageTimeScale, sampleRate / CompressorKernel::slowStageStride),
+                 calculateReleaseCoefficient(releaseMs * CompressorKernel::slowStageTimeScale, sampleRate / CompressorKernel::slowStageStride) };
+    }
 
 
-    
+    // Host blocks of any size are processed in chunks of at most this many
+    // samples, so the working set of the inner loops stays in L1.
+    static constexpr int maxChunkSize = 128;
     
 private:
     juce::AudioBuffer<float> inputBuffer;
     juce::AudioBuffer<float> outputBuffer;
     
-    float envelope;
+    std::vector<CompressorChannelState> channelStates; // One per channel, sized in prepareToPlay
+    
+    juce::AudioProcessLoadMeasurer loadMeasurer;
+    std::atomic<double> worstBlockMs { 0.0 };
+    BlockTelemetry telemetry;
+    LevelMeterSource meterSource;
+    
+    SpectrumCapture spectrumCapture;
+    juce::AudioBuffer<float> analyzerInput; // One chunk of pre-compression input
+    
+    LoudnessMeter loudnessMeter;
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Squeeze1AudioProcessor)
@@ -0,0 +1,159 @@
+/*
+  ==============================================================================
+
+    RealtimeSafety.cpp
+
+  ==============================================================================
+*/
+
+#include "RealtimeSafety.h"
+
+#if SQUEEZE1_REALTIME_CHECKS
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if JUCE_LINUX || JUCE_BSD || JUCE_MAC
+ #include <dlfcn.h>
+ #include <pthread.h>
+#endif
+
+namespace
+{
+    thread_local bool audioThreadArmed = false;
+
+    [[noreturn]] void reportViolation(const char* what) noexcept
+    {
+        audioThreadArmed = false; // Reporting must not trip the check again
+
+        std::fprintf(stderr, "Squeeze1: real-time violation on the audio thread: %s\n", what);
+        std::fflush(stderr);
+        std::abort();
+    }
+
+    inline void check(const char* what) noexcept
+    {
+        if (audioThreadArmed)
+            reportViolation(what);
+    }
+
+    void* allocate(std::size_t size, const char* what)
+    {
+        check(what);
+
+        if (auto* ptr = std::malloc(size == 0 ? 1 : size))
+            return ptr;
+
+        throw std::bad_alloc();
+    }
+
+    void* allocate(std::size_t size, const char* what, const std::nothrow_t&) noexcept
+    {
+        check(what);
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    void deallocate(void* ptr, const char* what) noexcept
+    {
+        if (ptr != nullptr)
+            check(what);
+
+        std::free(ptr);
+    }
+}
+
+//==============================================================================
+RealtimeSafety::ScopedAudioThread::ScopedAudioThread() noexcept : wasArmed(audioThreadArmed)
+{
+    audioThreadArmed = true;
+}
+
+RealtimeSafety::ScopedAudioThread::~ScopedAudioThread() noexcept
+{
+    audioThreadArmed = wasArmed;
+}
+
+RealtimeSafety::ScopedAllow::ScopedAllow() noexcept : wasArmed(audioThreadArmed)
+{
+    audioThreadArmed = false;
+}
+
+RealtimeSafety::ScopedAllow::~ScopedAllow() noexcept
+{
+    audioThreadArmed = wasArmed;
+}
+
+bool RealtimeSafety::isArmed() noexcept
+{
+    return audioThreadArmed;
+}
+
+//==============================================================================
+// Replacing the global allocation functions catches every new/delete made by
+// code linked into the plugin, including JUCE and std containers.
+void* operator new   (std::size_t size)                                 { return allocate(size, "operator new"); }
+void* operator new[] (std::size_t size)                                 { return allocate(size, "operator new[]"); }
+void* operator new   (std::size_t size, const std::nothrow_t& tag) noexcept { return allocate(size, "operator new", tag); }
+void* operator new[] (std::size_t size, const std::nothrow_t& tag) noexcept { return allocate(size, "operator new[]", tag); }
+
+void operator delete   (void* ptr) noexcept                             { deallocate(ptr, "operator delete"); }
+void operator delete[] (void* ptr) noexcept                             { deallocate(ptr, "operator delete[]"); }
+void operator delete   (void* ptr, std::size_t) noexcept                { deallocate(ptr, "operator delete"); }
+void operator delete[] (void* ptr, std::size_t) noexcept                { deallocate(ptr, "operator delete[]"); }
+void operator delete   (void* ptr, const std::nothrow_t&) noexcept      { deallocate(ptr, "operator delete"); }
+void operator delete[] (void* ptr, const std::nothrow_t&) noexcept      { deallocate(ptr, "operator delete[]"); }
+
+//==============================================================================
+#if defined (__GLIBC__)
+// juce::HeapBlock, and with it AudioBuffer::setSize and MemoryBlock, allocates
+// with these rather than operator new. glibc exports its implementations under
+// __libc_ names, so they're forwarded to without dlsym, which allocates itself.
+extern "C"
+{
+    void* __libc_malloc (std::size_t) noexcept;
+    void* __libc_calloc (std::size_t, std::size_t) noexcept;
+    void* __libc_realloc (void*, std::size_t) noexcept;
+    void  __libc_free (void*) noexcept;
+
+    void* malloc (std::size_t size) noexcept                   { check("malloc");  return __libc_malloc(size); }
+    void* calloc (std::size_t count, std::size_t size) noexcept { check("calloc");  return __libc_calloc(count, size); }
+    void* realloc (void* ptr, std::size_t size) noexcept       { check("realloc"); return __libc_realloc(ptr, size); }
+
+    void free (void* ptr) noexcept
+    {
+        if (ptr != nullptr)
+            check("free");
+
+        __libc_free(ptr);
+    }
+}
+#endif
+
+//==============================================================================
+#if JUCE_LINUX || JUCE_BSD || JUCE_MAC
+// Interposes the blocking lock used by juce::CriticalSection, std::mutex (on
+// libstdc++) and most third-party code. Try-locks are left alone, since they
+// are the sanctioned way of touching shared state from the audio thread.
+extern "C" int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    using LockFunction = int (*)(pthread_mutex_t*);
+
+    // Constant-initialized, so unlike a dynamically initialized static it has
+    // no guard variable whose first-use locking could re-enter this function
+    static std::atomic<LockFunction> realLock { nullptr };
+
+    auto lock = realLock.load(std::memory_order_relaxed);
+
+    if (lock == nullptr)
+    {
+        lock = reinterpret_cast<LockFunction>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+        realLock.store(lock, std::memory_order_relaxed);
+    }
+
+    check("pthread_mutex_lock");
+    return lock(mutex);
+}
+#endif
+
+#endif
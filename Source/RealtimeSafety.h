@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    RealtimeSafety.h
+    Debug-build guard that fails loudly when the audio thread allocates or
+    blocks on a mutex.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Enabled in debug builds by default; define SQUEEZE1_REALTIME_CHECKS=1 in the
+// Projucer preprocessor definitions to arm it in a release/test build as well.
+#ifndef SQUEEZE1_REALTIME_CHECKS
+ #define SQUEEZE1_REALTIME_CHECKS JUCE_DEBUG
+#endif
+
+namespace RealtimeSafety
+{
+   #if SQUEEZE1_REALTIME_CHECKS
+    /** Marks the calling thread as the audio thread while in scope.
+
+        Any operator new/delete, malloc/calloc/realloc/free (with glibc) or
+        (on POSIX) pthread_mutex_lock made from the thread while it is armed
+        prints the offending call and aborts.
+
+        The hooks work by symbol replacement, so they only take effect where
+        this code is linked into the executable (the Standalone build,
+        Squeeze1Cli) or on macOS. In a plugin loaded with dlopen on Linux, the
+        host's libc and libstdc++ symbols are bound first and nothing is
+        checked; run the Standalone or Squeeze1Cli's "rtcheck" command instead.
+        On macOS, malloc and friends are bound in libSystem and can't be
+        replaced this way, so only operator new/delete and locks are checked
+        there; juce::HeapBlock allocations go unnoticed.
+    */
+    class ScopedAudioThread
+    {
+    public:
+        ScopedAudioThread() noexcept;
+        ~ScopedAudioThread() noexcept;
+
+    private:
+        bool wasArmed;
+        JUCE_DECLARE_NON_COPYABLE (ScopedAudioThread)
+    };
+
+    /** Disarms the check while in scope, for code that is deliberately exempt. */
+    class ScopedAllow
+    {
+    public:
+        ScopedAllow() noexcept;
+        ~ScopedAllow() noexcept;
+
+    private:
+        bool wasArmed;
+        JUCE_DECLARE_NON_COPYABLE (ScopedAllow)
+    };
+
+    bool isArmed() noexcept;
+   #else
+    struct ScopedAudioThread { ScopedAudioThread() noexcept {} };
+    struct ScopedAllow       { ScopedAllow() noexcept {} };
+
+    inline bool isArmed() noexcept { return false; }
+   #endif
+}
+
+#if SQUEEZE1_REALTIME_CHECKS
+ // A failed jassert or a DBG builds a String, which would be reported as the
+ // violation and hide the actual failure. These expand JUCE's macros with the
+ // check disarmed, for code that includes this header; assertions inside JUCE's
+ // own headers and modules are expanded before it and aren't covered.
+ #if JUCE_LOG_ASSERTIONS || JUCE_DEBUG
+  #undef JUCE_LOG_CURRENT_ASSERTION
+  #define JUCE_LOG_CURRENT_ASSERTION  { const RealtimeSafety::ScopedAllow realtimeAssertion; juce::logAssertion (__FILE__, __LINE__); }
+ #endif
+
+ #if JUCE_DEBUG
+  #undef DBG
+  #define DBG(textToWrite)  JUCE_BLOCK_WITH_FORCED_SEMICOLON (const RealtimeSafety::ScopedAllow realtimeLog; \
+                                                             juce::String tempDbgBuf; tempDbgBuf << textToWrite; \
+                                                             juce::Logger::outputDebugString (tempDbgBuf);)
+ #endif
+#endif
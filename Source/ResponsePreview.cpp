@@ -0,0 +1,220 @@
+/*
+  ==============================================================================
+
+    ResponsePreview.cpp
+
+  ==============================================================================
+*/
+
+#include "ResponsePreview.h"
+
+namespace
+{
+    constexpr float curveMinDb = -36.0f;
+    constexpr int numCurvePoints = 96;
+    constexpr int convergenceChunk = 64;
+}
+
+//==============================================================================
+ResponsePreview::ResponsePreview() : juce::Thread("Squeeze1 response preview")
+{
+    startThread();
+}
+
+ResponsePreview::~ResponsePreview()
+{
+    stopThread(2000);
+}
+
+void ResponsePreview::requestRender(const CompressorSettings& settings, double sampleRate, int width, int height)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        pendingRequest = { settings, sampleRate > 0.0 ? sampleRate : 44100.0, width, height };
+        hasPendingRequest = true;
+    }
+
+    notify();
+}
+
+juce::Image ResponsePreview::getImage() const
+{
+    const juce::ScopedLock sl(lock);
+    return image;
+}
+
+//==============================================================================
+void ResponsePreview::run()
+{
+    while (! threadShouldExit())
+    {
+        Request request;
+
+        {
+            const juce::ScopedLock sl(lock);
+
+            if (hasPendingRequest)
+            {
+                request = pendingRequest;
+                hasPendingRequest = false;
+            }
+        }
+
+        if (request.width <= 0 || request.height <= 0)
+        {
+            wait(-1);
+            continue;
+        }
+
+        auto rendered = render(request);
+
+        if (threadShouldExit())
+            return;
+
+        {
+            const juce::ScopedLock sl(lock);
+            image = rendered;
+        }
+
+        sendChangeMessage();
+    }
+}
+
+juce::Image ResponsePreview::render(const Request& request)
+{
+    juce::Image rendered(juce::Image::ARGB, request.width, request.height, true, juce::SoftwareImageType());
+    juce::Graphics g(rendered);
+
+    auto bounds = rendered.getBounds().toFloat();
+    drawStepResponse(g, request, bounds);
+
+    auto insetSize = bounds.getHeight() * 0.45f;
+    drawTransferCurve(g, request, bounds.reduced(6.0f).removeFromTop(insetSize).removeFromRight(insetSize));
+
+    return rendered;
+}
+
+//==============================================================================
+// Drives the kernel with a full-scale burst and draws what comes out: the
+// output magnitude above the centre line, the detector envelope mirrored below.
+void ResponsePreview::drawStepResponse(juce::Graphics& g, const Request& request, juce::Rectangle<float> bounds)
+{
+    auto settings = request.settings;
+    settings.linearGain = 1.0f; // Dynamics only; makeup gain would just rescale the picture
+
+    // With auto release, long enough for the slow stage to charge and recover;
+    // it steps once per stride rather than per sample
+    auto attackCoeff = settings.autoRelease ? settings.slowAttackCoeff : settings.attackCoeff;
+    auto releaseCoeff = settings.autoRelease ? settings.slowReleaseCoeff : settings.releaseCoeff;
+    auto coeffRate = settings.autoRelease ? request.sampleRate / CompressorKernel::slowStageStride : request.sampleRate;
+    
+    auto attackSeconds = -1.0 / (coeffRate * std::log(1.0 - (double) attackCoeff));
+    auto releaseSeconds = -1.0 / (coeffRate * std::log(1.0 - (double) releaseCoeff));
+
+    auto burstSeconds = juce::jmax(0.02, 5.0 * attackSeconds);
+    auto tailSeconds = juce::jmax(0.02, 5.0 * releaseSeconds);
+    auto leadSeconds = 0.1 * (burstSeconds + tailSeconds);
+
+    auto burstStart = (int) (leadSeconds * request.sampleRate);
+    auto burstEnd = burstStart + (int) (burstSeconds * request.sampleRate);
+    auto totalSamples = burstEnd + (int) (tailSeconds * request.sampleRate);
+
+    auto width = (int) bounds.getWidth();
+    auto midY = bounds.getCentreY();
+    auto halfHeight = bounds.getHeight() * 0.5f;
+
+    juce::Path outputPath, envelopePath;
+    outputPath.startNewSubPath(bounds.getX(), midY);
+    envelopePath.startNewSubPath(bounds.getX(), midY);
+
+    CompressorChannelState state;
+    CompressorStats stats;
+    int sample = 0;
+
+    for (int x = 0; x < width; ++x)
+    {
+        auto columnEnd = (int) ((juce::int64) totalSamples * (x + 1) / width);
+        float columnPeak = 0.0f;
+
+        for (; sample < columnEnd; ++sample)
+        {
+            float value = (sample >= burstStart && sample < burstEnd) ? 1.0f : 0.0f;
+            CompressorKernel::process(&value, 1, state, settings, stats);
+            columnPeak = juce::jmax(columnPeak, std::abs(value));
+        }
+
+        auto px = bounds.getX() + (float) x;
+        outputPath.lineTo(px, midY - juce::jmin(columnPeak, 1.0f) * halfHeight);
+        envelopePath.lineTo(px, midY + juce::jmin(CompressorKernel::getEnvelope(state, settings), 1.0f) * halfHeight);
+
+        if (threadShouldExit())
+            return;
+    }
+
+    g.setColour(juce::Colours::lightskyblue);
+    g.strokePath(outputPath, juce::PathStrokeType(1.0f));
+    g.setColour(juce::Colours::violet);
+    g.strokePath(envelopePath, juce::PathStrokeType(1.0f));
+}
+
+// Runs each input level to steady state through the kernel and plots the
+// resulting output level, both axes from curveMinDb to 0dB.
+void ResponsePreview::drawTransferCurve(juce::Graphics& g, const Request& request, juce::Rectangle<float> bounds)
+{
+    auto settings = request.settings;
+    settings.linearGain = 1.0f;
+
+    auto dbToX = [&] (float db) { return juce::jmap(db, curveMinDb, 0.0f, bounds.getX(), bounds.getRight()); };
+    auto dbToY = [&] (float db) { return juce::jmap(juce::jlimit(curveMinDb, 0.0f, db), curveMinDb, 0.0f, bounds.getBottom(), bounds.getY()); };
+
+    g.setColour(juce::Colours::black.withAlpha(0.8f));
+    g.fillRect(bounds);
+    g.setColour(juce::Colours::darkslategrey);
+    g.drawRect(bounds);
+    g.drawLine(bounds.getX(), bounds.getBottom(), bounds.getRight(), bounds.getY(), 1.0f);
+
+    auto thresholdDb = juce::Decibels::gainToDecibels(settings.linearThreshold);
+    g.drawVerticalLine(juce::roundToInt(dbToX(thresholdDb)), bounds.getY(), bounds.getBottom());
+
+    // Long enough for the slowest attack to settle well within float precision
+    auto maxSamples = juce::jmax(convergenceChunk, (int) (20.0 / juce::jmax(settings.attackCoeff, 1.0e-6f)));
+
+    std::array<float, convergenceChunk> block;
+    juce::Path curve;
+
+    for (int point = 0; point < numCurvePoints; ++point)
+    {
+        auto inputDb = juce::jmap((float) point, 0.0f, (float) (numCurvePoints - 1), curveMinDb, 0.0f);
+        auto inputGain = juce::Decibels::decibelsToGain(inputDb);
+
+        CompressorChannelState state;
+        float output = 0.0f;
+        CompressorStats stats;
+
+        for (int done = 0; done < maxSamples; done += convergenceChunk)
+        {
+            block.fill(inputGain);
+            CompressorKernel::process(block.data(), convergenceChunk, state, settings, stats);
+
+            auto previous = output;
+            output = block.back();
+
+            if (done > 0 && std::abs(output - previous) < 1.0e-7f)
+                break;
+        }
+
+        auto outputDb = juce::Decibels::gainToDecibels(output, curveMinDb - 1.0f);
+        juce::Point<float> p(dbToX(inputDb), dbToY(outputDb));
+
+        if (point == 0)
+            curve.startNewSubPath(p);
+        else
+            curve.lineTo(p);
+
+        if (threadShouldExit())
+            return;
+    }
+
+    g.setColour(juce::Colours::lightskyblue);
+    g.strokePath(curve, juce::PathStrokeType(1.5f));
+}
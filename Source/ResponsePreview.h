@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    ResponsePreview.h
+    Renders the kernel's actual static transfer curve and step response on a
+    background thread, so the editor only has to blit the result.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CompressorKernel.h"
+
+//==============================================================================
+class ResponsePreview : public juce::ChangeBroadcaster,
+                        private juce::Thread
+{
+public:
+    ResponsePreview();
+    ~ResponsePreview() override;
+
+    // Message thread. Requests made while a render is running are coalesced,
+    // so only the newest settings get simulated.
+    void requestRender(const CompressorSettings& settings, double sampleRate, int width, int height);
+
+    // Message thread. The most recently finished preview (null until the first
+    // render completes); a change message is sent whenever it is replaced.
+    juce::Image getImage() const;
+
+private:
+    struct Request
+    {
+        CompressorSettings settings;
+        double sampleRate = 44100.0;
+        int width = 0;
+        int height = 0;
+    };
+
+    void run() override;
+    juce::Image render(const Request& request);
+
+    void drawStepResponse(juce::Graphics& g, const Request& request, juce::Rectangle<float> bounds);
+    void drawTransferCurve(juce::Graphics& g, const Request& request, juce::Rectangle<float> bounds);
+
+    juce::CriticalSection lock;
+    Request pendingRequest;
+    bool hasPendingRequest = false;
+    juce::Image image;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResponsePreview)
+};
@@ -0,0 +1,226 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyzer.h"
+
+namespace
+{
+    constexpr double minFrequency = 20.0;
+    constexpr double maxFrequency = 20000.0;
+    constexpr float smoothing = 0.6f;     // Weight of the previous frame per hop
+    constexpr float reductionRangeDb = 24.0f;
+}
+
+//==============================================================================
+void SpectrumCapture::push(const float* input, const float* output, int numSamples) noexcept
+{
+    if (! isActive())
+        return;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    std::copy(input, input + size1, inputSamples.begin() + start1);
+    std::copy(output, output + size1, outputSamples.begin() + start1);
+    std::copy(input + size1, input + size1 + size2, inputSamples.begin() + start2);
+    std::copy(output + size1, output + size1 + size2, outputSamples.begin() + start2);
+
+    fifo.finishedWrite(size1 + size2);
+}
+
+int SpectrumCapture::pull(float* input, float* output, int maxSamples) noexcept
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(maxSamples, start1, size1, start2, size2);
+
+    std::copy(inputSamples.begin() + start1, inputSamples.begin() + start1 + size1, input);
+    std::copy(outputSamples.begin() + start1, outputSamples.begin() + start1 + size1, output);
+    std::copy(inputSamples.begin() + start2, inputSamples.begin() + start2 + size2, input + size1);
+    std::copy(outputSamples.begin() + start2, outputSamples.begin() + start2 + size2, output + size1);
+
+    fifo.finishedRead(size1 + size2);
+    return size1 + size2;
+}
+
+//==============================================================================
+SpectrumAnalyzer::SpectrumAnalyzer(SpectrumCapture& captureToRead)
+    : juce::Thread("Squeeze1 spectrum analyzer"),
+      capture(captureToRead),
+      inputHistory((size_t) fftSize, 0.0f),
+      outputHistory((size_t) fftSize, 0.0f),
+      fftData((size_t) fftSize * 2, 0.0f)
+{
+    smoothed.inputDb.fill(minDb);
+    smoothed.outputDb.fill(minDb);
+    published = smoothed;
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    stop();
+}
+
+void SpectrumAnalyzer::start()
+{
+    capture.setActive(true);
+    startThread();
+}
+
+void SpectrumAnalyzer::stop()
+{
+    capture.setActive(false);
+    stopThread(1000);
+}
+
+SpectrumAnalyzer::Spectrum SpectrumAnalyzer::getSpectrum() const
+{
+    const juce::SpinLock::ScopedLockType sl(publishLock);
+    return published;
+}
+
+//==============================================================================
+void SpectrumAnalyzer::run()
+{
+    std::vector<float> inputBlock((size_t) hopSize), outputBlock((size_t) hopSize);
+    int samplesSinceFrame = 0;
+
+    while (! threadShouldExit())
+    {
+        auto numPulled = capture.pull(inputBlock.data(), outputBlock.data(), hopSize - samplesSinceFrame);
+
+        if (numPulled == 0)
+        {
+            wait(10);
+            continue;
+        }
+
+        // Slide the analysis windows along by what just arrived
+        for (auto* history : { &inputHistory, &outputHistory })
+            std::move(history->begin() + numPulled, history->end(), history->begin());
+
+        std::copy(inputBlock.begin(), inputBlock.begin() + numPulled, inputHistory.end() - numPulled);
+        std::copy(outputBlock.begin(), outputBlock.begin() + numPulled, outputHistory.end() - numPulled);
+
+        samplesSinceFrame += numPulled;
+
+        if (samplesSinceFrame < hopSize)
+            continue;
+
+        samplesSinceFrame = 0;
+
+        auto sampleRate = capture.getSampleRate();
+
+        if (sampleRate != mappedSampleRate)
+            updateColumnMapping(sampleRate);
+
+        analyse(inputHistory, smoothed.inputDb);
+        analyse(outputHistory, smoothed.outputDb);
+
+        const juce::SpinLock::ScopedLockType sl(publishLock);
+        published = smoothed;
+    }
+}
+
+// Precomputes which FFT bins feed each display column, so a frame is reduced
+// with one pass over the bins instead of per-pixel frequency maths. The edges
+// stay on the log axis: low columns narrower than a bin share it, since
+// analyse() reads at least the bin at each column's lower edge.
+void SpectrumAnalyzer::updateColumnMapping(double sampleRate)
+{
+    mappedSampleRate = sampleRate;
+
+    constexpr int numBins = fftSize / 2;
+    auto topFrequency = juce::jmin(maxFrequency, sampleRate * 0.5);
+
+    for (int column = 0; column <= numColumns; ++column)
+    {
+        auto frequency = minFrequency * std::pow(topFrequency / minFrequency, (double) column / numColumns);
+        columnBinEdges[(size_t) column] = juce::jlimit(1, numBins, (int) std::round(frequency * fftSize / sampleRate));
+    }
+}
+
+void SpectrumAnalyzer::analyse(const std::vector<float>& history, std::array<float, numColumns>& smoothedDb)
+{
+    std::copy(history.begin(), history.end(), fftData.begin());
+    std::fill(fftData.begin() + fftSize, fftData.end(), 0.0f);
+
+    window.multiplyWithWindowingTable(fftData.data(), (size_t) fftSize);
+    fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+    // A full-scale sine through a Hann window peaks at fftSize / 4
+    constexpr float normalisation = 4.0f / (float) fftSize;
+
+    for (int column = 0; column < numColumns; ++column)
+    {
+        auto firstBin = fftData.begin() + columnBinEdges[(size_t) column];
+        auto lastBin = fftData.begin() + juce::jmax(columnBinEdges[(size_t) column + 1], columnBinEdges[(size_t) column] + 1);
+        auto magnitude = *std::max_element(firstBin, juce::jmin(lastBin, fftData.begin() + fftSize / 2 + 1));
+
+        auto db = juce::Decibels::gainToDecibels(magnitude * normalisation, minDb);
+        auto& value = smoothedDb[(size_t) column];
+        value = smoothing * value + (1.0f - smoothing) * db;
+    }
+}
+
+//==============================================================================
+void SpectrumComponent::paint(juce::Graphics& g)
+{
+    auto spectrum = analyzer.getSpectrum();
+    auto bounds = getLocalBounds().toFloat();
+
+    auto columnToX = [&] (int column)
+    {
+        return juce::jmap((float) column, 0.0f, (float) (SpectrumAnalyzer::numColumns - 1), bounds.getX(), bounds.getRight());
+    };
+
+    auto levelToY = [&] (float db)
+    {
+        return juce::jmap(juce::jlimit(SpectrumAnalyzer::minDb, 0.0f, db), SpectrumAnalyzer::minDb, 0.0f, bounds.getBottom(), bounds.getY());
+    };
+
+    auto reductionToY = [&] (float db)
+    {
+        return juce::jmap(juce::jlimit(-reductionRangeDb, reductionRangeDb, db), -reductionRangeDb, reductionRangeDb,
+                          bounds.getBottom(), bounds.getY());
+    };
+
+    juce::Path inputPath, outputPath, reductionPath;
+
+    for (int column = 0; column < SpectrumAnalyzer::numColumns; ++column)
+    {
+        auto x = columnToX(column);
+        auto inputDb = spectrum.inputDb[(size_t) column];
+        auto outputDb = spectrum.outputDb[(size_t) column];
+
+        // Only meaningful where there is signal to compare
+        auto reductionDb = inputDb > SpectrumAnalyzer::minDb + 20.0f ? outputDb - inputDb : 0.0f;
+
+        if (column == 0)
+        {
+            inputPath.startNewSubPath(x, levelToY(inputDb));
+            outputPath.startNewSubPath(x, levelToY(outputDb));
+            reductionPath.startNewSubPath(x, reductionToY(reductionDb));
+        }
+        else
+        {
+            inputPath.lineTo(x, levelToY(inputDb));
+            outputPath.lineTo(x, levelToY(outputDb));
+            reductionPath.lineTo(x, reductionToY(reductionDb));
+        }
+    }
+
+    g.setColour(juce::Colours::darkslategrey);
+    g.drawHorizontalLine(juce::roundToInt(bounds.getCentreY()), bounds.getX(), bounds.getRight());
+
+    g.setColour(juce::Colours::white.withAlpha(0.6f));
+    g.strokePath(inputPath, juce::PathStrokeType(1.0f));
+    g.setColour(juce::Colours::orange);
+    g.strokePath(outputPath, juce::PathStrokeType(1.5f));
+    g.setColour(juce::Colours::violet);
+    g.strokePath(reductionPath, juce::PathStrokeType(1.0f));
+}
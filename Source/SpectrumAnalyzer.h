@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.h
+    Input/output spectrum and gain-reduction-vs-frequency display. The audio
+    thread only copies samples into SpectrumCapture; the FFTs run on the
+    analyzer's own thread while the editor shows it.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Single-producer/single-consumer hand-over of matching input and output
+    samples. Nothing is copied unless an analyzer has switched it on.
+*/
+class SpectrumCapture
+{
+public:
+    static constexpr int capacity = 1 << 15;
+
+    SpectrumCapture() : fifo(capacity), inputSamples((size_t) capacity), outputSamples((size_t) capacity) {}
+
+    void setSampleRate(double newSampleRate) noexcept { sampleRate.store(newSampleRate, std::memory_order_relaxed); }
+    double getSampleRate() const noexcept { return sampleRate.load(std::memory_order_relaxed); }
+
+    void setActive(bool shouldBeActive) noexcept { active.store(shouldBeActive, std::memory_order_relaxed); }
+    bool isActive() const noexcept { return active.load(std::memory_order_relaxed); }
+
+    // Audio thread. Samples that don't fit are dropped rather than waited for.
+    void push(const float* input, const float* output, int numSamples) noexcept;
+
+    // Analyzer thread. Returns the number of samples copied.
+    int pull(float* input, float* output, int maxSamples) noexcept;
+
+private:
+    juce::AbstractFifo fifo;
+    std::vector<float> inputSamples, outputSamples;
+    std::atomic<double> sampleRate { 44100.0 };
+    std::atomic<bool> active { false };
+
+    JUCE_DECLARE_NON_COPYABLE (SpectrumCapture)
+};
+
+//==============================================================================
+/**
+    Hann-windowed FFTs with 75% overlap, reduced to a fixed number of
+    log-spaced columns between 20Hz and 20kHz.
+*/
+class SpectrumAnalyzer : private juce::Thread
+{
+public:
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 4;
+    static constexpr int numColumns = 128;
+
+    static constexpr float minDb = -90.0f;
+
+    struct Spectrum
+    {
+        std::array<float, numColumns> inputDb;
+        std::array<float, numColumns> outputDb;
+    };
+
+    explicit SpectrumAnalyzer(SpectrumCapture& captureToRead);
+    ~SpectrumAnalyzer() override;
+
+    // Message thread
+    void start();
+    void stop();
+    Spectrum getSpectrum() const;
+
+private:
+    void run() override;
+    void updateColumnMapping(double sampleRate);
+    void analyse(const std::vector<float>& history, std::array<float, numColumns>& smoothedDb);
+
+    SpectrumCapture& capture;
+
+    juce::dsp::FFT fft { fftOrder };
+    juce::dsp::WindowingFunction<float> window { (size_t) fftSize, juce::dsp::WindowingFunction<float>::hann, false };
+
+    std::vector<float> inputHistory, outputHistory, fftData;
+    std::array<int, numColumns + 1> columnBinEdges {};
+    double mappedSampleRate = 0.0;
+
+    Spectrum smoothed;
+    Spectrum published;
+    juce::SpinLock publishLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumAnalyzer)
+};
+
+//==============================================================================
+/**
+    Draws the latest spectrum; transparent, so it sits on top of the output
+    window and lets clicks through to the editor.
+*/
+class SpectrumComponent : public juce::Component
+{
+public:
+    explicit SpectrumComponent(SpectrumAnalyzer& analyzerToShow) : analyzer(analyzerToShow)
+    {
+        setInterceptsMouseClicks(false, false);
+    }
+
+    void paint(juce::Graphics& g) override;
+
+private:
+    SpectrumAnalyzer& analyzer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumComponent)
+};
@@ -0,0 +1,192 @@
+/*
+  ==============================================================================
+
+    TraceEvents.cpp
+
+  ==============================================================================
+*/
+
+#include "TraceEvents.h"
+
+#if SQUEEZE1_ENABLE_TRACING
+
+namespace
+{
+    struct Event
+    {
+        const char* name;
+        juce::int64 startTicks;
+        juce::int64 endTicks;
+    };
+
+    // Accessed through relaxed atomics, since the exporter reads slots the
+    // writer may be overwriting; writeCount tells it which copies to drop
+    struct EventSlot
+    {
+        std::atomic<const char*> name { nullptr };
+        std::atomic<juce::int64> startTicks { 0 };
+        std::atomic<juce::int64> endTicks { 0 };
+
+        void store(const Event& event) noexcept
+        {
+            name.store(event.name, std::memory_order_relaxed);
+            startTicks.store(event.startTicks, std::memory_order_relaxed);
+            endTicks.store(event.endTicks, std::memory_order_relaxed);
+        }
+
+        Event load() const noexcept
+        {
+            return { name.load(std::memory_order_relaxed), startTicks.load(std::memory_order_relaxed),
+                     endTicks.load(std::memory_order_relaxed) };
+        }
+    };
+
+    // Single-producer ring: only the owning thread writes, the exporter reads.
+    struct ThreadBuffer
+    {
+        static constexpr juce::uint64 capacity = 8192;
+
+        std::array<EventSlot, capacity> events;
+        std::atomic<juce::uint64> writeCount { 0 };
+        std::atomic<bool> isMessageThread { false };
+        std::atomic<bool> isClaimed { false };
+    };
+
+    // Statically allocated so the first marker hit on the audio thread
+    // doesn't allocate
+    constexpr int maxThreads = 16;
+    ThreadBuffer threadBuffers[maxThreads];
+    std::atomic<int> numUsedBuffers { 0 };      // Slots claimed at least once
+    std::atomic<int> numDroppedThreads { 0 };   // Threads that found every slot taken
+
+    // Claims a free slot on a thread's first event and frees it when the thread
+    // exits, so short-lived threads don't use the slots up. A later thread
+    // carries on from the events the previous owner left in the slot.
+    struct SlotClaim
+    {
+        SlotClaim() noexcept
+        {
+            for (int index = 0; index < maxThreads; ++index)
+            {
+                auto wasClaimed = false;
+
+                if (threadBuffers[index].isClaimed.compare_exchange_strong(wasClaimed, true))
+                {
+                    buffer = &threadBuffers[index];
+                    buffer->isMessageThread.store(juce::MessageManager::existsAndIsCurrentThread());
+
+                    auto numUsed = numUsedBuffers.load();
+
+                    while (numUsed <= index && ! numUsedBuffers.compare_exchange_weak(numUsed, index + 1)) {}
+
+                    return;
+                }
+            }
+
+            numDroppedThreads.fetch_add(1);
+        }
+
+        ~SlotClaim()
+        {
+            if (buffer != nullptr)
+                buffer->isClaimed.store(false);
+        }
+
+        ThreadBuffer* buffer = nullptr;
+    };
+
+    ThreadBuffer* getThreadBuffer() noexcept
+    {
+        thread_local SlotClaim claim;
+        return claim.buffer;
+    }
+
+    double ticksToMicroseconds(juce::int64 ticks)
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6;
+    }
+}
+
+void TraceEvents::record(const char* name, juce::int64 startTicks, juce::int64 endTicks) noexcept
+{
+    if (auto* buffer = getThreadBuffer())
+    {
+        auto index = buffer->writeCount.load(std::memory_order_relaxed);
+
+        // Orders the previous event's writeCount before this event's stores, so an
+        // exporter that sees any of them also sees at least that count
+        std::atomic_thread_fence(std::memory_order_release);
+        buffer->events[index % ThreadBuffer::capacity].store({ name, startTicks, endTicks });
+        buffer->writeCount.store(index + 1, std::memory_order_release);
+    }
+}
+
+juce::String TraceEvents::exportChromeJson()
+{
+    juce::MemoryOutputStream json;
+    // Threads that started while all the slots were taken recorded nothing
+    json << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedThreads\":" << numDroppedThreads.load()
+         << "},\"traceEvents\":[";
+
+    auto isFirstEvent = true;
+    auto numBuffers = numUsedBuffers.load();
+
+    for (int tid = 0; tid < numBuffers; ++tid)
+    {
+        auto& buffer = threadBuffers[tid];
+
+        auto end = buffer.writeCount.load(std::memory_order_acquire);
+        auto begin = end > ThreadBuffer::capacity ? end - ThreadBuffer::capacity : 0;
+
+        std::vector<Event> snapshot;
+        snapshot.reserve((size_t) (end - begin));
+
+        for (auto i = begin; i < end; ++i)
+            snapshot.push_back(buffer.events[i % ThreadBuffer::capacity].load());
+
+        // Anything the writer lapped while we were copying may be torn, as may
+        // the slot it could be storing index endAfterCopy into right now. The
+        // fence keeps the copies above from moving past this second read.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        auto endAfterCopy = buffer.writeCount.load(std::memory_order_relaxed);
+        auto firstValid = endAfterCopy + 1 > ThreadBuffer::capacity ? endAfterCopy + 1 - ThreadBuffer::capacity : 0;
+        auto numTorn = (size_t) juce::jlimit<juce::uint64>(0, end - begin, firstValid > begin ? firstValid - begin : 0);
+
+        json << (isFirstEvent ? "" : ",")
+             << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+             << ",\"args\":{\"name\":\"" << (buffer.isMessageThread.load() ? juce::String("Message thread")
+                                                                               : "Thread " + juce::String(tid)) << "\"}}";
+        isFirstEvent = false;
+
+        for (auto i = numTorn; i < snapshot.size(); ++i)
+        {
+            const auto& event = snapshot[i];
+
+            json << ",{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                 << ",\"ts\":" << juce::String(ticksToMicroseconds(event.startTicks), 3)
+                 << ",\"dur\":" << juce::String(ticksToMicroseconds(event.endTicks - event.startTicks), 3) << "}";
+        }
+    }
+
+    json << "]}";
+    return json.toString();
+}
+
+bool TraceEvents::writeChromeJson(const juce::File& file)
+{
+    return file.replaceWithText(exportChromeJson());
+}
+
+#else
+
+juce::String TraceEvents::exportChromeJson()
+{
+    return "{\"traceEvents\":[]}";
+}
+
+bool TraceEvents::writeChromeJson(const juce::File&)
+{
+    return false;
+}
+
+#endif
@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    TraceEvents.h
+    Scoped trace markers for the DSP and GUI hot paths, exported as Chrome /
+    Perfetto JSON (open in chrome://tracing or ui.perfetto.dev).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Off by default; define SQUEEZE1_ENABLE_TRACING=1 in the Projucer
+// preprocessor definitions to compile the markers in.
+#ifndef SQUEEZE1_ENABLE_TRACING
+ #define SQUEEZE1_ENABLE_TRACING 0
+#endif
+
+namespace TraceEvents
+{
+   #if SQUEEZE1_ENABLE_TRACING
+    /** Records a wait-free event into the calling thread's own buffer.
+        Names must be string literals, since only the pointer is stored.
+
+        Up to 16 threads can record at once; a thread's buffer is freed for
+        reuse when it exits. Threads beyond that record nothing, and the
+        export counts them in otherData.droppedThreads.
+    */
+    void record(const char* name, juce::int64 startTicks, juce::int64 endTicks) noexcept;
+
+    class ScopedEvent
+    {
+    public:
+        explicit ScopedEvent(const char* eventName) noexcept
+            : name(eventName), startTicks(juce::Time::getHighResolutionTicks()) {}
+
+        ~ScopedEvent() noexcept { record(name, startTicks, juce::Time::getHighResolutionTicks()); }
+
+    private:
+        const char* name;
+        juce::int64 startTicks;
+        JUCE_DECLARE_NON_COPYABLE (ScopedEvent)
+    };
+   #endif
+
+    /** Builds a Chrome trace from every thread's buffer. Safe to call while
+        other threads keep recording; events overwritten mid-export are dropped.
+        Returns an empty trace when tracing is compiled out.
+    */
+    juce::String exportChromeJson();
+
+    /** Writes exportChromeJson() to a file, returning false on failure or when
+        tracing is compiled out.
+    */
+    bool writeChromeJson(const juce::File& file);
+}
+
+#if SQUEEZE1_ENABLE_TRACING
+ #define SQUEEZE1_TRACE_SCOPE(name) TraceEvents::ScopedEvent JUCE_JOIN_MACRO (traceEvent_, __LINE__) (name)
+#else
+ #define SQUEEZE1_TRACE_SCOPE(name)
+#endif
@@ -0,0 +1,715 @@
+/*
+  ==============================================================================
+
+    DspFuzz.cpp
+
+  ==============================================================================
+*/
+
+#include "DspFuzz.h"
+#include "OfflineRender.h"
+#include "ReferenceCompressor.h"
+#include <iostream>
+
+namespace
+{
+    const double sampleRates[] { 22050.0, 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 };
+    const int hostBlockSizes[] { 32, 64, 128, 256, 441, 512, 1024, 4096 };
+
+    // Half the draws land on a range limit, where the coefficients are most extreme
+    float pickValue(juce::Random& random, float minimum, float maximum)
+    {
+        switch (random.nextInt(4))
+        {
+            case 0:  return minimum;
+            case 1:  return maximum;
+            default: return minimum + (maximum - minimum) * random.nextFloat();
+        }
+    }
+
+    // Ranges match the plugin's parameter layout
+    ReferenceCompressor::Parameters makeParameters(juce::Random& random)
+    {
+        ReferenceCompressor::Parameters parameters;
+        parameters.thresholdDb = pickValue(random, -24.0f, 0.0f);
+        parameters.ratio = pickValue(random, 1.0f, 20.0f);
+        parameters.attackMs = pickValue(random, 0.1f, 100.0f);
+        parameters.releaseMs = pickValue(random, 10.0f, 1000.0f);
+        parameters.gainDb = pickValue(random, 0.0f, 24.0f);
+        return parameters;
+    }
+
+    juce::String describe(const ReferenceCompressor::Parameters& parameters)
+    {
+        return "threshold " + juce::String(parameters.thresholdDb) + "dB, ratio " + juce::String(parameters.ratio)
+             + ", attack " + juce::String(parameters.attackMs) + "ms, release " + juce::String(parameters.releaseMs)
+             + "ms, gain " + juce::String(parameters.gainDb) + "dB";
+    }
+
+    //==============================================================================
+    enum class Signal { noise, sine, fullScale, bursts, nearThreshold, denormals, nonFinite, silence, numSignals };
+
+    const char* getSignalName(Signal signal)
+    {
+        switch (signal)
+        {
+            case Signal::noise:         return "noise";
+            case Signal::sine:          return "sine";
+            case Signal::fullScale:     return "full-scale square";
+            case Signal::bursts:        return "bursts";
+            case Signal::nearThreshold: return "at threshold";
+            case Signal::denormals:     return "denormals";
+            case Signal::nonFinite:     return "NaN/Inf";
+            case Signal::silence:
+            case Signal::numSignals:
+            default:                    return "silence";
+        }
+    }
+
+    void fillSignal(juce::AudioBuffer<float>& buffer, Signal signal, float linearThreshold, double sampleRate, juce::Random& random)
+    {
+        auto level = juce::Decibels::decibelsToGain(-40.0f + 46.0f * random.nextFloat()); // Up to +6 dBFS
+        auto frequency = 20.0 + 5000.0 * random.nextDouble();
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                auto noise = random.nextFloat() * 2.0f - 1.0f;
+                auto value = 0.0f;
+
+                switch (signal)
+                {
+                    case Signal::noise:
+                        value = level * noise;
+                        break;
+
+                    case Signal::sine:
+                        value = level * (float) std::sin(juce::MathConstants<double>::twoPi * frequency * i / sampleRate + channel);
+                        break;
+
+                    case Signal::fullScale:
+                        value = noise < 0.0f ? -1.0f : 1.0f;
+                        break;
+
+                    case Signal::bursts: // Alternating loud and quiet stretches, for attack and release
+                        value = ((i / 2048) % 2 == 0 ? level : level * 0.01f) * noise;
+                        break;
+
+                    case Signal::nearThreshold: // The comparison boundary, give or take an ulp
+                        value = std::nextafter(linearThreshold, noise < -0.33f ? 0.0f : 2.0f);
+                        value = (noise > 0.33f ? linearThreshold : value) * (random.nextBool() ? 1.0f : -1.0f);
+                        break;
+
+                    case Signal::denormals:
+                        value = std::numeric_limits<float>::denorm_min() * (float) random.nextInt(1 << 20) * (noise < 0.0f ? -1.0f : 1.0f);
+
+                        if (random.nextInt(64) == 0)
+                            value = level * noise;
+                        break;
+
+                    case Signal::nonFinite:
+                        value = level * noise;
+
+                        switch (random.nextInt(512))
+                        {
+                            case 0:  value = std::numeric_limits<float>::quiet_NaN(); break;
+                            case 1:  value = std::numeric_limits<float>::infinity(); break;
+                            case 2:  value = -std::numeric_limits<float>::infinity(); break;
+                            default: break;
+                        }
+                        break;
+
+                    case Signal::silence:
+                    case Signal::numSignals:
+                    default:
+                        break;
+                }
+
+                buffer.setSample(channel, i, value);
+            }
+        }
+    }
+
+    //==============================================================================
+    bool matches(float expected, float actual, float tolerance)
+    {
+        if (std::isnan(expected) || std::isnan(actual))
+            return std::isnan(expected) && std::isnan(actual);
+
+        if (std::isinf(expected) || std::isinf(actual))
+            return expected == actual;
+
+        return std::abs(actual - expected) <= tolerance * juce::jmax(1.0f, std::abs(expected));
+    }
+
+    // Empty if the buffers match, otherwise the first differing sample
+    juce::String compare(const juce::AudioBuffer<float>& expected, const juce::AudioBuffer<float>& actual, float tolerance)
+    {
+        for (int channel = 0; channel < expected.getNumChannels(); ++channel)
+        {
+            for (int i = 0; i < expected.getNumSamples(); ++i)
+            {
+                auto expectedValue = expected.getSample(channel, i);
+                auto actualValue = actual.getSample(channel, i);
+
+                if (! matches(expectedValue, actualValue, tolerance))
+                    return "channel " + juce::String(channel) + ", sample " + juce::String(i) + ": expected "
+                         + juce::String(expectedValue, 9) + ", got " + juce::String(actualValue, 9);
+            }
+        }
+
+        return {};
+    }
+
+    // Mostly typical sizes, with awkward ones and oversized host blocks mixed in
+    int nextSplit(juce::Random& random, int remaining, int typicalSize)
+    {
+        const int awkwardSizes[] { 0, 1, 2, 3, 31, 127, 128, 129 };
+        int size;
+
+        switch (random.nextInt(4))
+        {
+            case 0:  size = awkwardSizes[random.nextInt(juce::numElementsInArray(awkwardSizes))]; break;
+            case 1:  size = typicalSize * 2 + random.nextInt(typicalSize); break;
+            default: size = 1 + random.nextInt(typicalSize); break;
+        }
+
+        return juce::jmin(size, remaining);
+    }
+
+    //==============================================================================
+    std::unique_ptr<Squeeze1AudioProcessor> createProcessor(const ReferenceCompressor::Parameters& parameters, double sampleRate,
+                                                            int numChannels, int samplesPerBlock,
+                                                            bool feedback = false, bool autoRelease = false)
+    {
+        OfflineRender::Options options;
+        options.blockSize = samplesPerBlock;
+        options.parameterValues.set("THRESHOLD", juce::String(parameters.thresholdDb, 9));
+        options.parameterValues.set("RATIO", juce::String(parameters.ratio, 9));
+        options.parameterValues.set("ATTACK", juce::String(parameters.attackMs, 9));
+        options.parameterValues.set("RELEASE", juce::String(parameters.releaseMs, 9));
+        options.parameterValues.set("GAIN", juce::String(parameters.gainDb, 9));
+        options.parameterValues.set("TOPOLOGY", feedback ? "1" : "0");
+        options.parameterValues.set("AUTO_RELEASE", autoRelease ? "1" : "0");
+
+        return OfflineRender::createProcessor(options, sampleRate, numChannels);
+    }
+
+    // The processor snaps values to its parameter intervals, so the reference
+    // is given what the processor actually runs with
+    ReferenceCompressor::Parameters getParameters(Squeeze1AudioProcessor& processor)
+    {
+        ReferenceCompressor::Parameters parameters;
+        parameters.thresholdDb = processor.apvts.getRawParameterValue("THRESHOLD")->load();
+        parameters.ratio = processor.apvts.getRawParameterValue("RATIO")->load();
+        parameters.attackMs = processor.apvts.getRawParameterValue("ATTACK")->load();
+        parameters.releaseMs = processor.apvts.getRawParameterValue("RELEASE")->load();
+        parameters.gainDb = processor.apvts.getRawParameterValue("GAIN")->load();
+        return parameters;
+    }
+
+    void processInHostBlocks(Squeeze1AudioProcessor& processor, juce::AudioBuffer<float>& audio, int samplesPerBlock, juce::Random& random)
+    {
+        juce::MidiBuffer midi;
+
+        for (int start = 0; start < audio.getNumSamples();)
+        {
+            auto size = nextSplit(random, audio.getNumSamples() - start, samplesPerBlock);
+            juce::AudioBuffer<float> block(audio.getArrayOfWritePointers(), audio.getNumChannels(), start, size);
+            processor.processBlock(block, midi);
+            start += size;
+        }
+    }
+
+    //==============================================================================
+    // CompressorKernel::process, called with arbitrary splits, against one reference pass
+    juce::String runKernelCase(juce::Random& random, float tolerance)
+    {
+        auto sampleRate = sampleRates[random.nextInt(juce::numElementsInArray(sampleRates))];
+        auto numChannels = 1 + random.nextInt(8);
+        auto numSamples = random.nextInt(16384);
+        auto parameters = makeParameters(random);
+        auto signal = (Signal) random.nextInt((int) Signal::numSignals);
+
+        auto settings = Squeeze1AudioProcessor::makeSettings(parameters.thresholdDb, parameters.ratio, parameters.attackMs,
+                                                             parameters.releaseMs, parameters.gainDb, sampleRate);
+
+        juce::AudioBuffer<float> expected(numChannels, numSamples);
+        fillSignal(expected, signal, settings.linearThreshold, sampleRate, random);
+        juce::AudioBuffer<float> actual(expected);
+
+        ReferenceCompressor reference;
+        reference.prepare(sampleRate, numChannels);
+        reference.process(expected, parameters);
+
+        {
+            juce::ScopedNoDenormals noDenormals; // As in processBlock
+            std::vector<CompressorChannelState> states((size_t) numChannels);
+            CompressorStats stats;
+
+            for (int start = 0; start < numSamples;)
+            {
+                auto size = nextSplit(random, numSamples - start, Squeeze1AudioProcessor::maxChunkSize);
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    CompressorKernel::process(actual.getWritePointer(channel, start), size, states[(size_t) channel], settings, stats);
+
+                start += size;
+            }
+        }
+
+        auto mismatch = compare(expected, actual, tolerance);
+
+        if (mismatch.isEmpty())
+            return {};
+
+        return mismatch + " (" + describe(parameters) + "; " + juce::String(sampleRate) + "Hz, " + juce::String(numChannels)
+             + " channel(s), " + juce::String(numSamples) + " samples of " + getSignalName(signal) + ")";
+    }
+
+    // Feedback and auto release postdate the reference, so they're checked for
+    // giving the same result however the audio is split, against one whole pass
+    juce::String runModesCase(juce::Random& random, float tolerance)
+    {
+        auto sampleRate = sampleRates[random.nextInt(juce::numElementsInArray(sampleRates))];
+        auto numSamples = random.nextInt(16384);
+        auto parameters = makeParameters(random);
+        auto signal = (Signal) random.nextInt((int) Signal::numSignals);
+        auto mode = 1 + random.nextInt(3);
+
+        auto settings = Squeeze1AudioProcessor::makeSettings(parameters.thresholdDb, parameters.ratio, parameters.attackMs,
+                                                             parameters.releaseMs, parameters.gainDb, sampleRate,
+                                                             (mode & 1) != 0, (mode & 2) != 0);
+
+        juce::AudioBuffer<float> expected(1, numSamples);
+        fillSignal(expected, signal, settings.linearThreshold, sampleRate, random);
+        juce::AudioBuffer<float> actual(expected);
+
+        juce::ScopedNoDenormals noDenormals;
+        CompressorStats stats;
+
+        CompressorChannelState wholeState;
+        CompressorKernel::process(expected.getWritePointer(0), numSamples, wholeState, settings, stats);
+
+        CompressorChannelState splitState;
+
+        for (int start = 0; start < numSamples;)
+        {
+            auto size = nextSplit(random, numSamples - start, Squeeze1AudioProcessor::maxChunkSize);
+            CompressorKernel::process(actual.getWritePointer(0, start), size, splitState, settings, stats);
+            start += size;
+        }
+
+        auto mismatch = compare(expected, actual, tolerance);
+
+        if (mismatch.isEmpty())
+            return {};
+
+        return mismatch + " (" + describe(parameters) + (settings.feedback ? ", feedback" : "") + (settings.autoRelease ? ", auto release" : "")
+             + "; " + juce::String(sampleRate) + "Hz, " + juce::String(numSamples) + " samples of " + getSignalName(signal) + ")";
+    }
+
+    // Feedback and auto release against what CompressorKernel documents for them:
+    // both topologies settling at the selected ratio for a constant input above
+    // the threshold, feedback letting the onset through, and auto release still
+    // holding the gain down one release time after that input drops below the
+    // threshold, where feed-forward lets go at once.
+    juce::String runBehaviourCase(juce::Random& random, float)
+    {
+        auto sampleRate = sampleRates[random.nextInt(juce::numElementsInArray(sampleRates))];
+        auto parameters = makeParameters(random);
+        parameters.ratio = juce::jmax(parameters.ratio, 2.0f); // Where the ratio is well clear of no compression
+
+        auto makeSettings = [&] (bool feedback, bool autoRelease)
+        {
+            auto settings = Squeeze1AudioProcessor::makeSettings(parameters.thresholdDb, parameters.ratio, parameters.attackMs,
+                                                                 parameters.releaseMs, parameters.gainDb, sampleRate,
+                                                                 feedback, autoRelease);
+            settings.linearGain = 1.0f; // Levels are checked before makeup gain
+            return settings;
+        };
+
+        auto threshold = makeSettings(false, false).linearThreshold;
+        auto loud = threshold * (1.5f + random.nextFloat());
+        auto quiet = threshold * 0.5f;
+        auto excess = loud - threshold;
+
+        // Long enough for the slow stage to settle, then one release time of the knob
+        auto numLoudSamples = (int) (20.0f / makeSettings(false, true).slowAttackCoeff) * CompressorKernel::slowStageStride;
+        auto numQuietSamples = juce::jmax(1, juce::roundToInt(parameters.releaseMs * sampleRate / 1000.0));
+
+        auto render = [&] (bool feedback, bool autoRelease)
+        {
+            std::vector<float> audio((size_t) (numLoudSamples + numQuietSamples), quiet);
+            std::fill_n(audio.begin(), numLoudSamples, loud);
+
+            juce::ScopedNoDenormals noDenormals;
+            CompressorChannelState state;
+            CompressorStats stats;
+            CompressorKernel::process(audio.data(), (int) audio.size(), state, makeSettings(feedback, autoRelease), stats);
+            return audio;
+        };
+
+        auto feedForward = render(false, false);
+        auto feedback = render(true, false);
+        auto autoRelease = render(false, true);
+        auto settled = (size_t) numLoudSamples - 1;
+
+        // At the longest time constants, float smoothing stalls short of its target:
+        // the detectors by up to about a tenth of a percent of the excess, and the
+        // slow stage by about a percent of its gain
+        auto isNear = [&] (float expected, float actual) { return std::abs(actual - expected) <= 0.01f * excess; };
+        auto isNearLevel = [] (float expected, float actual) { return std::abs(actual - expected) <= 0.02f * expected; };
+
+        auto expected = threshold + excess / parameters.ratio;
+        juce::String failure;
+
+        if (! isNear(expected, feedForward[settled]))
+            failure = "feed-forward settled at " + juce::String(feedForward[settled], 9) + ", expected " + juce::String(expected, 9);
+        else if (! isNear(expected, feedback[settled]))
+            failure = "feedback settled at " + juce::String(feedback[settled], 9) + ", expected " + juce::String(expected, 9);
+        else if (! isNear(loud, feedback[0]))
+            failure = "feedback took the onset down to " + juce::String(feedback[0], 9) + " from " + juce::String(loud, 9);
+        else if (isNear(loud, feedForward[0]))
+            failure = "feed-forward let the onset through at " + juce::String(feedForward[0], 9);
+        else if (! isNearLevel(feedForward[settled], autoRelease[settled]))
+            failure = "auto release settled at " + juce::String(autoRelease[settled], 9) + ", feed-forward at " + juce::String(feedForward[settled], 9);
+        else if (feedForward.back() != quiet)
+            failure = "feed-forward changed input below the threshold to " + juce::String(feedForward.back(), 9);
+        else
+        {
+            // The slow stage has 10 release times to recover in, so it should have
+            // let go of only about a tenth of the reduction by now
+            auto settledReduction = 1.0f - feedForward[settled] / loud;
+            auto heldReduction = 1.0f - autoRelease.back() / quiet;
+
+            if (heldReduction < 0.5f * settledReduction)
+                failure = "auto release held " + juce::String(heldReduction, 6) + " of gain reduction after one release time, "
+                        + juce::String(settledReduction, 6) + " while the input was loud";
+        }
+
+        if (failure.isEmpty())
+            return {};
+
+        return failure + " (" + describe(parameters) + "; " + juce::String(sampleRate) + "Hz, " + juce::String(numLoudSamples)
+             + " samples at " + juce::String(loud, 6) + " then " + juce::String(numQuietSamples) + " at " + juce::String(quiet, 6) + ")";
+    }
+
+    // Attack slower than release, where picking whichever step goes further
+    // would swap them. Each stage is checked against its closed form after a
+    // time constant: the feedback detector's attack, its release towards a lower
+    // level still above the threshold, and its release below the threshold, then
+    // the slow stage charging and recovering.
+    juce::String runTimingCase(juce::Random& random, float)
+    {
+        auto sampleRate = sampleRates[random.nextInt(juce::numElementsInArray(sampleRates))];
+        auto parameters = makeParameters(random);
+        parameters.ratio = juce::jmax(parameters.ratio, 2.0f);
+        parameters.releaseMs = pickValue(random, 10.0f, 50.0f);
+        parameters.attackMs = pickValue(random, 2.0f * parameters.releaseMs, 100.0f);
+
+        auto makeSettings = [&] (bool feedback, bool autoRelease)
+        {
+            auto settings = Squeeze1AudioProcessor::makeSettings(parameters.thresholdDb, parameters.ratio, parameters.attackMs,
+                                                                 parameters.releaseMs, parameters.gainDb, sampleRate,
+                                                                 feedback, autoRelease);
+            settings.linearGain = 1.0f;
+            return settings;
+        };
+
+        juce::ScopedNoDenormals noDenormals;
+        CompressorChannelState state;
+        CompressorStats stats;
+
+        auto feed = [&] (float level, int numSamples, const CompressorSettings& settings)
+        {
+            std::vector<float> audio((size_t) numSamples, level);
+            CompressorKernel::process(audio.data(), numSamples, state, settings, stats);
+        };
+
+        auto describeFailure = [&] (const juce::String& stage, double expected, float actual)
+        {
+            return stage + " reached " + juce::String(actual, 9) + ", expected " + juce::String(expected, 9) + " ("
+                 + describe(parameters) + "; " + juce::String(sampleRate) + "Hz)";
+        };
+
+        // Feedback: the reduction r steps along r * (1 - c * ratio) + c * (ratio - 1) * x,
+        // towards (ratio - 1) / ratio * x, while the output is above the threshold
+        auto feedback = makeSettings(true, false);
+        auto ratio = (double) feedback.ratio;
+        auto attackCoeff = juce::jmin((double) feedback.attackCoeff, 1.0 / ratio);
+        auto releaseCoeff = juce::jmin((double) feedback.releaseCoeff, 1.0 / ratio);
+        auto threshold = feedback.linearThreshold;
+        auto loud = threshold * (1.5f + random.nextFloat());
+        auto excess = (double) (loud - threshold);
+        auto isNear = [&] (double expected, float actual) { return std::abs(actual - expected) <= 0.01 * excess; };
+
+        // Short of the knob's times, which the loop runs about ratio times faster
+        auto numAttackSamples = juce::jmax(1, juce::roundToInt(parameters.attackMs * sampleRate / 1000.0 / ratio));
+        auto numReleaseSamples = juce::jmax(1, juce::roundToInt(parameters.releaseMs * sampleRate / 1000.0 / ratio));
+
+        auto target = (ratio - 1.0) / ratio * excess;
+        feed(loud, numAttackSamples, feedback);
+        auto expected = target * (1.0 - std::pow(1.0 - attackCoeff * ratio, numAttackSamples));
+
+        if (! isNear(expected, CompressorKernel::getEnvelope(state, feedback)))
+            return describeFailure("feedback attack", expected, CompressorKernel::getEnvelope(state, feedback));
+
+        feed(loud, (int) (20.0 / (attackCoeff * ratio)), feedback);
+        auto settled = (double) CompressorKernel::getEnvelope(state, feedback);
+
+        if (! isNear(target, (float) settled))
+            return describeFailure("feedback settling", target, (float) settled);
+
+        // Halfway down to the reduction, so the output stays above the threshold
+        auto lowerExcess = 0.5 * (settled + excess);
+        auto lowerTarget = (ratio - 1.0) / ratio * lowerExcess;
+        feed(threshold + (float) lowerExcess, numReleaseSamples, feedback);
+        expected = lowerTarget + (settled - lowerTarget) * std::pow(1.0 - releaseCoeff * ratio, numReleaseSamples);
+
+        if (! isNear(expected, CompressorKernel::getEnvelope(state, feedback)))
+            return describeFailure("feedback release above the threshold", expected, CompressorKernel::getEnvelope(state, feedback));
+
+        // Below the threshold there's no output to compare with, only the release
+        auto released = (double) CompressorKernel::getEnvelope(state, feedback);
+        auto numIdleSamples = juce::jmax(1, juce::roundToInt(parameters.releaseMs * sampleRate / 1000.0));
+        feed(threshold * 0.5f, numIdleSamples, feedback);
+        expected = released * std::pow(1.0 - releaseCoeff, numIdleSamples);
+
+        if (! isNear(expected, CompressorKernel::getEnvelope(state, feedback)))
+            return describeFailure("feedback release below the threshold", expected, CompressorKernel::getEnvelope(state, feedback));
+
+        // Auto release, on feed-forward already settled at its detector gain, so
+        // only the slow stage moves: once per stride, towards that gain and then
+        // back to unity
+        auto autoRelease = makeSettings(false, true);
+        state = {};
+        state.envelope = (float) (excess / ratio);
+        auto gain = (threshold + state.envelope) / (double) loud;
+        auto isNearGain = [&] (double expectedGain, float actual) { return std::abs(actual - expectedGain) <= 0.01 * (1.0 - gain); };
+
+        auto numStrides = juce::jmax(1, juce::roundToInt(1.0 / autoRelease.slowAttackCoeff));
+        feed(loud, numStrides * CompressorKernel::slowStageStride, autoRelease);
+        auto charged = gain + (1.0 - gain) * std::pow(1.0 - (double) autoRelease.slowAttackCoeff, numStrides);
+
+        if (! isNearGain(charged, state.slowGain))
+            return describeFailure("slow stage attack", charged, state.slowGain);
+
+        charged = state.slowGain;
+        numStrides = juce::jmax(1, juce::roundToInt(1.0 / autoRelease.slowReleaseCoeff));
+        feed(threshold * 0.5f, numStrides * CompressorKernel::slowStageStride, autoRelease);
+        expected = 1.0 - (1.0 - charged) * std::pow(1.0 - (double) autoRelease.slowReleaseCoeff, numStrides);
+
+        if (! isNearGain(expected, state.slowGain))
+            return describeFailure("slow stage release", expected, state.slowGain);
+
+        return {};
+    }
+
+    // processBlock with host blocks of varying size, including larger than prepared
+    juce::String runProcessBlockCase(juce::Random& random, float tolerance)
+    {
+        auto sampleRate = sampleRates[random.nextInt(juce::numElementsInArray(sampleRates))];
+        auto numChannels = 1 + random.nextInt(2);
+        auto samplesPerBlock = hostBlockSizes[random.nextInt(juce::numElementsInArray(hostBlockSizes))];
+        auto signal = (Signal) random.nextInt((int) Signal::numSignals);
+
+        auto processor = createProcessor(makeParameters(random), sampleRate, numChannels, samplesPerBlock);
+        auto parameters = getParameters(*processor);
+        processor->prepareToPlay(sampleRate, samplesPerBlock);
+
+        juce::AudioBuffer<float> expected(numChannels, random.nextInt((int) sampleRate / 2));
+        fillSignal(expected, signal, juce::Decibels::decibelsToGain(parameters.thresholdDb), sampleRate, random);
+        juce::AudioBuffer<float> actual(expected);
+
+        ReferenceCompressor reference;
+        reference.prepare(sampleRate, numChannels);
+        reference.process(expected, parameters);
+
+        processInHostBlocks(*processor, actual, samplesPerBlock, random);
+
+        auto mismatch = compare(expected, actual, tolerance);
+
+        if (mismatch.isEmpty())
+            return {};
+
+        return mismatch + " (" + describe(parameters) + "; " + juce::String(sampleRate) + "Hz, " + juce::String(numChannels)
+             + " channel(s), " + juce::String(samplesPerBlock) + "-sample blocks of " + getSignalName(signal) + ")";
+    }
+
+    // The same audio as one big block and as a random sequence of host blocks,
+    // in every detector mode. Each channel keeps its own detector state across
+    // the fixed-size chunks, so this must hold exactly, not just within tolerance.
+    juce::String runBlockSplitCase(juce::Random& random, float)
+    {
+        auto sampleRate = sampleRates[random.nextInt(juce::numElementsInArray(sampleRates))];
+        auto numChannels = 1 + random.nextInt(2);
+        auto samplesPerBlock = hostBlockSizes[random.nextInt(juce::numElementsInArray(hostBlockSizes))];
+        auto signal = (Signal) random.nextInt((int) Signal::numSignals);
+        auto parameters = makeParameters(random);
+        auto mode = random.nextInt(4);
+        auto feedback = (mode & 1) != 0, autoRelease = (mode & 2) != 0;
+
+        juce::AudioBuffer<float> expected(numChannels, 1 + random.nextInt((int) sampleRate / 2));
+        fillSignal(expected, signal, juce::Decibels::decibelsToGain(parameters.thresholdDb), sampleRate, random);
+        juce::AudioBuffer<float> actual(expected);
+
+        auto whole = createProcessor(parameters, sampleRate, numChannels, expected.getNumSamples(), feedback, autoRelease);
+        whole->prepareToPlay(sampleRate, expected.getNumSamples());
+        juce::MidiBuffer midi;
+        whole->processBlock(expected, midi);
+
+        auto split = createProcessor(parameters, sampleRate, numChannels, samplesPerBlock, feedback, autoRelease);
+        split->prepareToPlay(sampleRate, samplesPerBlock);
+        processInHostBlocks(*split, actual, samplesPerBlock, random);
+
+        auto mismatch = compare(expected, actual, 0.0f);
+
+        if (mismatch.isEmpty())
+            return {};
+
+        return mismatch + " (" + describe(getParameters(*split)) + (feedback ? ", feedback" : "") + (autoRelease ? ", auto release" : "")
+             + "; " + juce::String(sampleRate) + "Hz, "
+             + juce::String(numChannels) + " channel(s), one " + juce::String(expected.getNumSamples())
+             + "-sample block vs. " + juce::String(samplesPerBlock) + "-sample host blocks of " + getSignalName(signal) + ")";
+    }
+
+    // After prepareToPlay, a used processor must behave exactly like a fresh one
+    juce::String runPrepareToPlayCase(juce::Random& random, float tolerance)
+    {
+        auto sampleRate = sampleRates[random.nextInt(juce::numElementsInArray(sampleRates))];
+        auto numChannels = 1 + random.nextInt(2);
+        auto samplesPerBlock = hostBlockSizes[random.nextInt(juce::numElementsInArray(hostBlockSizes))];
+        auto signal = (Signal) random.nextInt((int) Signal::numSignals);
+
+        auto processor = createProcessor(makeParameters(random), sampleRate, numChannels, samplesPerBlock);
+        auto parameters = getParameters(*processor);
+        processor->prepareToPlay(sampleRate, samplesPerBlock);
+
+        // Leaves the envelopes charged
+        juce::AudioBuffer<float> previous(numChannels, samplesPerBlock * (1 + random.nextInt(8)));
+        fillSignal(previous, Signal::fullScale, 0.0f, sampleRate, random);
+        processInHostBlocks(*processor, previous, samplesPerBlock, random);
+
+        // Hosts re-prepare with new settings, or the same ones more than once
+        if (random.nextBool())
+        {
+            sampleRate = sampleRates[random.nextInt(juce::numElementsInArray(sampleRates))];
+            samplesPerBlock = hostBlockSizes[random.nextInt(juce::numElementsInArray(hostBlockSizes))];
+            processor->setRateAndBufferSizeDetails(sampleRate, samplesPerBlock);
+        }
+
+        for (int i = 1 + random.nextInt(2); --i >= 0;)
+            processor->prepareToPlay(sampleRate, samplesPerBlock);
+
+        juce::AudioBuffer<float> expected(numChannels, random.nextInt((int) sampleRate / 4));
+        fillSignal(expected, signal, juce::Decibels::decibelsToGain(parameters.thresholdDb), sampleRate, random);
+        juce::AudioBuffer<float> actual(expected);
+
+        ReferenceCompressor reference;
+        reference.prepare(sampleRate, numChannels);
+        reference.process(expected, parameters);
+
+        processInHostBlocks(*processor, actual, samplesPerBlock, random);
+
+        auto mismatch = compare(expected, actual, tolerance);
+
+        if (mismatch.isEmpty())
+            return {};
+
+        return mismatch + " (" + describe(parameters) + "; re-prepared at " + juce::String(sampleRate) + "Hz, "
+             + juce::String(samplesPerBlock) + "-sample blocks of " + getSignalName(signal) + ")";
+    }
+}
+
+//==============================================================================
+int DspFuzz::run(const Options& options)
+{
+    struct Suite
+    {
+        const char* name;
+        juce::String (*runCase)(juce::Random&, float);
+    };
+
+    const Suite suites[] { { "kernel", runKernelCase },
+                           { "modes", runModesCase },
+                           { "behaviour", runBehaviourCase },
+                           { "timing", runTimingCase },
+                           { "processBlock", runProcessBlockCase },
+                           { "blockSplit", runBlockSplitCase },
+                           { "prepareToPlay", runPrepareToPlayCase } };
+
+    auto numFailures = 0;
+
+    for (auto& suite : suites)
+    {
+        auto numRun = 0, numSuiteFailures = 0;
+
+        for (int caseIndex = 0; caseIndex < options.numCases; ++caseIndex)
+        {
+            if (options.onlyCase >= 0 && caseIndex != options.onlyCase)
+                continue;
+
+            // Each case has its own generator, so any one can be replayed alone
+            juce::Random random(options.seed * 1000003 + caseIndex);
+            auto failure = suite.runCase(random, options.tolerance);
+            ++numRun;
+
+            if (failure.isNotEmpty())
+            {
+                ++numSuiteFailures;
+                std::cout << "FAIL " << suite.name << " case " << caseIndex << ": " << failure << "\n"
+                          << "  replay with: fuzz --seed=" << options.seed << " --case=" << caseIndex << std::endl;
+            }
+        }
+
+        std::cout << suite.name << ": " << (numRun - numSuiteFailures) << "/" << numRun << " cases match the reference" << std::endl;
+        numFailures += numSuiteFailures;
+    }
+
+    return numFailures;
+}
+
+//==============================================================================
+juce::ConsoleApplication::Command DspFuzz::createCommand()
+{
+    return { "fuzz",
+             "fuzz [--seed=N] [--cases=N] [--case=N] [--tolerance=x]",
+             "Checks Squeeze1's DSP against the frozen reference compressor.",
+             "Runs randomized cases against ReferenceCompressor in three suites: the kernel with arbitrary call\n"
+             "splits and up to 8 channels, processBlock with varying host block sizes, and processBlock after\n"
+             "re-preparing a used processor. A fourth checks that processBlock gives bit-identical output for one\n"
+             "big block and for a random sequence of host blocks, in every detector mode. The feedback and\n"
+             "auto-release modes, which the reference predates, are checked against a single whole-buffer pass\n"
+             "of the kernel instead, for settling at the selected ratio and how long auto release holds gain\n"
+             "reduction after loud input, and, with attack slower than release, for each stage's attack and\n"
+             "release time constants.\n"
+             "Cases draw random parameters, sample rates and signals, including denormals, NaN/Inf, full-scale\n"
+             "and at-threshold input. Finite samples must be within tolerance * max(1, |reference|) (default\n"
+             "1e-5); non-finite samples must match in kind.",
+             [] (const juce::ArgumentList& args)
+             {
+                 Options options;
+
+                 if (args.containsOption("--seed"))
+                     options.seed = args.getValueForOption("--seed").getLargeIntValue();
+
+                 if (args.containsOption("--cases"))
+                     options.numCases = juce::jmax(1, args.getValueForOption("--cases").getIntValue());
+
+                 if (args.containsOption("--case"))
+                 {
+                     options.onlyCase = juce::jmax(0, args.getValueForOption("--case").getIntValue());
+                     options.numCases = juce::jmax(options.numCases, options.onlyCase + 1);
+                 }
+
+                 if (args.containsOption("--tolerance"))
+                     options.tolerance = args.getValueForOption("--tolerance").getFloatValue();
+
+                 auto numFailures = run(options);
+
+                 if (numFailures > 0)
+                     juce::ConsoleApplication::fail(juce::String(numFailures) + " case(s) differ from the reference", 2);
+             } };
+}
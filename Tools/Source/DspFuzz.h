@@ -0,0 +1,36 @@
+/*
+  ==============================================================================
+
+    DspFuzz.h
+    "fuzz" command: differential check of the plugin's DSP against the
+    frozen ReferenceCompressor with randomized settings and signals.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+namespace DspFuzz
+{
+    /*  Tolerance: optimized code may reorder float arithmetic, so a finite
+        sample passes when it is within tolerance * max(1, |reference|) of the
+        reference, i.e. absolute below full scale and relative above it (makeup
+        gain reaches +24 dB). The default, 1e-5, is about -100 dBFS. Non-finite
+        samples must match exactly in kind: NaN for NaN, and Inf of the same sign.
+    */
+    struct Options
+    {
+        juce::int64 seed = 1;
+        int numCases = 200;        // Per suite
+        int onlyCase = -1;         // Replays a single case of each suite when >= 0
+        float tolerance = 1.0e-5f;
+    };
+
+    // Returns the number of failing cases
+    int run(const Options& options);
+
+    juce::ConsoleApplication::Command createCommand();
+}
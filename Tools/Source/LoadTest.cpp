@@ -0,0 +1,498 @@
+/*
+  ==============================================================================
+
+    LoadTest.cpp
+
+  ==============================================================================
+*/
+
+#include "LoadTest.h"
+#include <iostream>
+
+#if JUCE_LINUX
+ #include <linux/perf_event.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr int numWarmUpCycles = 50;
+
+    //==============================================================================
+    // Hardware cache misses of the calling thread, via perf_event where the
+    // kernel allows it (see /proc/sys/kernel/perf_event_paranoid).
+    class CacheMissCounter
+    {
+    public:
+        CacheMissCounter()
+        {
+           #if JUCE_LINUX
+            perf_event_attr attributes {};
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.size = sizeof(attributes);
+            attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+
+            fd = (int) syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+           #endif
+        }
+
+        ~CacheMissCounter()
+        {
+           #if JUCE_LINUX
+            if (fd >= 0)
+                close(fd);
+           #endif
+        }
+
+        bool isAvailable() const { return fd >= 0; }
+
+        juce::int64 read() const
+        {
+            juce::int64 value = 0;
+
+           #if JUCE_LINUX
+            if (fd >= 0 && ::read(fd, &value, sizeof(value)) != (ssize_t) sizeof(value))
+                value = 0;
+           #endif
+
+            return value;
+        }
+
+    private:
+        int fd = -1;
+        JUCE_DECLARE_NON_COPYABLE (CacheMissCounter)
+    };
+
+    //==============================================================================
+    struct Instance
+    {
+        std::unique_ptr<Squeeze1AudioProcessor> processor;
+        juce::AudioBuffer<float> source; // A second of test signal, looped
+        juce::AudioBuffer<float> block;
+        int sourcePosition = 0;
+        std::vector<float> blockMicroseconds;
+    };
+
+    // Each instance gets its own settings and signal level, so the set of
+    // instances exercises both compressing and idle paths.
+    Instance createInstance(int index, const LoadTest::Options& options, int numCycles)
+    {
+        Instance instance;
+        instance.processor = std::make_unique<Squeeze1AudioProcessor>();
+
+        juce::Random random(index);
+
+        for (auto* parameter : instance.processor->getParameters())
+            parameter->setValueNotifyingHost(random.nextFloat());
+
+        instance.processor->setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+        instance.processor->prepareToPlay(options.sampleRate, options.blockSize);
+
+        auto numChannels = instance.processor->getTotalNumOutputChannels();
+        auto level = juce::Decibels::decibelsToGain(-30.0f + 30.0f * random.nextFloat());
+        auto frequency = 50.0 + 2000.0 * random.nextDouble();
+
+        instance.source.setSize(numChannels, (int) options.sampleRate);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < instance.source.getNumSamples(); ++i)
+                instance.source.setSample(channel, i, level * (0.7f * (float) std::sin(juce::MathConstants<double>::twoPi * frequency * i / options.sampleRate)
+                                                               + 0.3f * (random.nextFloat() * 2.0f - 1.0f)));
+
+        instance.block.setSize(numChannels, options.blockSize);
+        instance.blockMicroseconds.assign((size_t) numCycles, 0.0f);
+        return instance;
+    }
+
+    //==============================================================================
+    // One cycle processes every instance once; workers claim instances from a
+    // shared counter, like a host scheduling a graph of independent tracks.
+    class Graph
+    {
+    public:
+        Graph(std::vector<Instance>& instancesToRun, int numThreads) : instances(instancesToRun)
+        {
+            for (int i = 0; i < numThreads; ++i)
+                workers.add(new Worker(*this));
+
+            for (auto* worker : workers)
+                worker->startThread();
+
+            while (numWorkersReady.load() < numThreads)
+                juce::Thread::yield();
+        }
+
+        ~Graph()
+        {
+            for (auto* worker : workers)
+                worker->signalThreadShouldExit();
+
+            for (auto* worker : workers)
+                worker->stopThread(1000);
+        }
+
+        // Returns the wall-clock time the whole cycle took
+        double runCycle(int cycle)
+        {
+            auto startTicks = juce::Time::getHighResolutionTicks();
+
+            currentCycle = cycle;
+            nextInstance.store(0, std::memory_order_relaxed);
+            numWorkersFinished.store(0, std::memory_order_relaxed);
+            generation.fetch_add(1, std::memory_order_release);
+
+            while (numWorkersFinished.load(std::memory_order_acquire) < workers.size())
+                juce::Thread::yield();
+
+            return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+        }
+
+        bool hasCacheMissCounters() const
+        {
+            for (auto* worker : workers)
+                if (! worker->hasCounter.load())
+                    return false;
+
+            return true;
+        }
+
+        juce::int64 getTotalCacheMisses() const
+        {
+            juce::int64 total = 0;
+
+            for (auto* worker : workers)
+                total += worker->cacheMisses.load();
+
+            return total;
+        }
+
+    private:
+        class Worker : public juce::Thread
+        {
+        public:
+            explicit Worker(Graph& graphToRun) : juce::Thread("Squeeze1 load test worker"), graph(graphToRun) {}
+
+            void run() override
+            {
+                CacheMissCounter counter; // Opened here, so it counts this thread only
+                hasCounter = counter.isAvailable();
+
+                auto seenGeneration = graph.generation.load(std::memory_order_acquire);
+                graph.numWorkersReady.fetch_add(1);
+                juce::MidiBuffer midi;
+
+                while (! threadShouldExit())
+                {
+                    auto currentGeneration = graph.generation.load(std::memory_order_acquire);
+
+                    if (currentGeneration == seenGeneration)
+                    {
+                        juce::Thread::yield();
+                        continue;
+                    }
+
+                    seenGeneration = currentGeneration;
+                    graph.processInstances(midi);
+
+                    cacheMisses.store(counter.read());
+                    graph.numWorkersFinished.fetch_add(1, std::memory_order_release);
+                }
+            }
+
+            std::atomic<bool> hasCounter { false };
+            std::atomic<juce::int64> cacheMisses { 0 };
+
+        private:
+            Graph& graph;
+        };
+
+        void processInstances(juce::MidiBuffer& midi)
+        {
+            auto cycle = currentCycle;
+
+            for (;;)
+            {
+                auto index = nextInstance.fetch_add(1, std::memory_order_relaxed);
+
+                if (index >= (int) instances.size())
+                    return;
+
+                auto& instance = instances[(size_t) index];
+                auto& block = instance.block;
+
+                for (int channel = 0; channel < block.getNumChannels(); ++channel)
+                    for (int done = 0, position = instance.sourcePosition; done < block.getNumSamples();)
+                    {
+                        auto numToCopy = juce::jmin(block.getNumSamples() - done, instance.source.getNumSamples() - position);
+                        block.copyFrom(channel, done, instance.source, channel, position, numToCopy);
+                        done += numToCopy;
+                        position = (position + numToCopy) % instance.source.getNumSamples();
+                    }
+
+                instance.sourcePosition = (instance.sourcePosition + block.getNumSamples()) % instance.source.getNumSamples();
+
+                auto startTicks = juce::Time::getHighResolutionTicks();
+                instance.processor->processBlock(block, midi);
+                auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+                if (cycle >= 0)
+                    instance.blockMicroseconds[(size_t) cycle] = (float) (elapsed * 1.0e6);
+            }
+        }
+
+        std::vector<Instance>& instances;
+        juce::OwnedArray<Worker> workers;
+
+        std::atomic<int> generation { 0 };
+        std::atomic<int> nextInstance { 0 };
+        std::atomic<int> numWorkersFinished { 0 };
+        std::atomic<int> numWorkersReady { 0 };
+        int currentCycle = -1; // Published to the workers by the generation bump
+    };
+
+    template <typename Value>
+    Value percentile(std::vector<Value> values, double proportion)
+    {
+        if (values.empty())
+            return {};
+
+        auto nth = values.begin() + (std::ptrdiff_t) juce::jlimit<double>(0.0, (double) values.size() - 1.0, std::ceil(proportion * (double) values.size()) - 1.0);
+        std::nth_element(values.begin(), nth, values.end());
+        return *nth;
+    }
+
+    void waitUntil(double targetMs)
+    {
+        for (;;)
+        {
+            auto remaining = targetMs - juce::Time::getMillisecondCounterHiRes();
+
+            if (remaining <= 0.0)
+                return;
+
+            if (remaining > 2.0)
+                juce::Thread::sleep((int) remaining - 1);
+            else
+                juce::Thread::yield();
+        }
+    }
+}
+
+//==============================================================================
+int LoadTest::run(const Options& options)
+{
+    auto periodMs = 1000.0 * options.blockSize / options.sampleRate;
+    auto numCycles = juce::jmax(1, (int) (options.secondsPerStep * options.sampleRate / options.blockSize));
+
+    std::cout << "Block " << options.blockSize << " @ " << options.sampleRate << "Hz (deadline " << periodMs << "ms), "
+              << options.numThreads << " worker(s), " << numCycles << " cycles per step, "
+              << (options.paced ? "paced" : "unpaced") << "\n"
+              << "Processor object: " << sizeof(Squeeze1AudioProcessor) << " bytes before heap allocations\n\n";
+
+    juce::String header("instances,threads,cycles,deadline_misses,miss_percent,p50_cycle_ms,p99_cycle_ms,max_cycle_ms,"
+                         "p99_instance_us,cache_misses_per_block");
+    std::cout << header << std::endl;
+
+    std::unique_ptr<juce::FileOutputStream> csv;
+
+    if (options.csvFile != juce::File())
+    {
+        options.csvFile.deleteFile();
+        csv = options.csvFile.createOutputStream();
+
+        if (csv != nullptr)
+            *csv << header << "\n";
+    }
+
+    for (auto numInstances : options.instanceCounts)
+    {
+        // Created and destroyed here on the main thread; workers only process
+        std::vector<Instance> instances;
+        instances.reserve((size_t) numInstances);
+
+        for (int i = 0; i < numInstances; ++i)
+            instances.push_back(createInstance(i, options, numCycles));
+
+        std::vector<double> cycleMs((size_t) numCycles);
+        juce::int64 cacheMisses = 0;
+        bool hasCacheMisses = false;
+
+        {
+            Graph graph(instances, options.numThreads);
+
+            for (int i = 0; i < numWarmUpCycles; ++i)
+                graph.runCycle(-1);
+
+            auto missesBefore = graph.getTotalCacheMisses();
+            auto nextStartMs = juce::Time::getMillisecondCounterHiRes();
+
+            for (int cycle = 0; cycle < numCycles; ++cycle)
+            {
+                if (options.paced)
+                {
+                    waitUntil(nextStartMs);
+                    nextStartMs += periodMs;
+                }
+
+                cycleMs[(size_t) cycle] = graph.runCycle(cycle);
+            }
+
+            hasCacheMisses = graph.hasCacheMissCounters();
+            cacheMisses = graph.getTotalCacheMisses() - missesBefore;
+        }
+
+        auto misses = std::count_if(cycleMs.begin(), cycleMs.end(), [&] (double ms) { return ms > periodMs; });
+
+        std::vector<float> allBlocks;
+        allBlocks.reserve((size_t) numInstances * (size_t) numCycles);
+
+        for (auto& instance : instances)
+            allBlocks.insert(allBlocks.end(), instance.blockMicroseconds.begin(), instance.blockMicroseconds.end());
+
+        juce::String row;
+        row << numInstances << "," << options.numThreads << "," << numCycles << ","
+            << (int) misses << "," << juce::String(100.0 * (double) misses / numCycles, 2) << ","
+            << juce::String(percentile(cycleMs, 0.5), 4) << ","
+            << juce::String(percentile(cycleMs, 0.99), 4) << ","
+            << juce::String(*std::max_element(cycleMs.begin(), cycleMs.end()), 4) << ","
+            << juce::String(percentile(allBlocks, 0.99), 2) << ","
+            << (hasCacheMisses ? juce::String((double) cacheMisses / ((double) numInstances * numCycles), 1) : juce::String("n/a"));
+
+        std::cout << row << std::endl;
+
+        if (csv != nullptr)
+            *csv << row << "\n";
+    }
+
+    return 0;
+}
+
+//==============================================================================
+int LoadTest::runKernelModes(const Options& options)
+{
+    constexpr int numRounds = 20;
+    constexpr int numModes = 4;
+
+    // Noise alternating above and below the threshold every tenth of a second,
+    // so the compressing, releasing and idle paths all run
+    juce::Random random(1);
+    std::vector<float> source((size_t) juce::jmax(1, (int) (options.secondsPerStep * options.sampleRate)));
+    auto sectionLength = juce::jmax(1, (int) (options.sampleRate / 10.0));
+
+    for (size_t i = 0; i < source.size(); ++i)
+        source[i] = (random.nextFloat() * 2.0f - 1.0f) * ((i / (size_t) sectionLength) % 2 == 0 ? 0.8f : 0.05f);
+
+    std::cout << "CompressorKernel on " << source.size() << " samples @ " << options.sampleRate << "Hz in "
+              << Squeeze1AudioProcessor::maxChunkSize << "-sample chunks, best of " << numRounds << " rounds\n\n";
+
+    juce::String header("topology,auto_release,ns_per_sample,relative_to_feed_forward,samples_over_threshold");
+    std::cout << header << std::endl;
+
+    std::unique_ptr<juce::FileOutputStream> csv;
+
+    if (options.csvFile != juce::File())
+    {
+        options.csvFile.deleteFile();
+        csv = options.csvFile.createOutputStream();
+
+        if (csv != nullptr)
+            *csv << header << "\n";
+    }
+
+    std::array<double, numModes> bestSeconds;
+    std::array<CompressorStats, numModes> stats;
+    bestSeconds.fill(std::numeric_limits<double>::max());
+    std::array<float, Squeeze1AudioProcessor::maxChunkSize> chunk;
+
+    juce::ScopedNoDenormals noDenormals; // As in processBlock
+
+    // Rounds interleave the modes, so clock and thermal drift hits them all alike
+    for (int round = 0; round < numRounds; ++round)
+    {
+        for (int mode = 0; mode < numModes; ++mode)
+        {
+            auto settings = Squeeze1AudioProcessor::makeSettings(-12.0f, 4.0f, 10.0f, 100.0f, 0.0f, options.sampleRate,
+                                                                 (mode & 1) != 0, (mode & 2) != 0);
+            CompressorChannelState state;
+            auto startTicks = juce::Time::getHighResolutionTicks();
+
+            for (size_t start = 0; start < source.size(); start += chunk.size())
+            {
+                auto size = juce::jmin(chunk.size(), source.size() - start);
+                std::copy_n(source.begin() + (std::ptrdiff_t) start, size, chunk.begin());
+                CompressorKernel::process(chunk.data(), (int) size, state, settings, stats[(size_t) mode]);
+            }
+
+            auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+            bestSeconds[(size_t) mode] = juce::jmin(bestSeconds[(size_t) mode], elapsed);
+        }
+    }
+
+    for (int mode = 0; mode < numModes; ++mode)
+    {
+        juce::String row;
+        row << ((mode & 1) != 0 ? "feedback" : "feed-forward") << "," << ((mode & 2) != 0 ? "on" : "off") << ","
+            << juce::String(bestSeconds[(size_t) mode] * 1.0e9 / (double) source.size(), 3) << ","
+            << juce::String(bestSeconds[(size_t) mode] / bestSeconds[0], 3) << ","
+            << stats[(size_t) mode].samplesOverThreshold / numRounds;
+
+        std::cout << row << std::endl;
+
+        if (csv != nullptr)
+            *csv << row << "\n";
+    }
+
+    return 0;
+}
+
+//==============================================================================
+juce::ConsoleApplication::Command LoadTest::createCommand()
+{
+    return { "loadtest",
+             "loadtest [--instances=1,2,4,...] [--threads=K] [--block=N] [--rate=Hz] [--seconds=S] [--unpaced] [--csv=file] [--kernel]",
+             "Measures how Squeeze1 scales with many instances across worker threads.",
+             "For each instance count, creates that many processors with varied settings and signals and runs them\n"
+             "across K worker threads, one graph cycle per block period. Reports deadline misses, cycle and\n"
+             "per-instance block-time percentiles and, where perf_event is available, cache misses per block.\n"
+             "With --kernel, instead times CompressorKernel alone on one thread in each topology and auto-release\n"
+             "combination over S seconds of test signal, and reports each relative to plain feed-forward.",
+             [] (const juce::ArgumentList& args)
+             {
+                 Options options;
+
+                 if (args.containsOption("--instances"))
+                 {
+                     options.instanceCounts.clear();
+
+                     for (auto& count : juce::StringArray::fromTokens(args.getValueForOption("--instances"), ",", {}))
+                         if (count.getIntValue() > 0)
+                             options.instanceCounts.add(count.getIntValue());
+                 }
+
+                 if (args.containsOption("--threads"))
+                     options.numThreads = juce::jmax(1, args.getValueForOption("--threads").getIntValue());
+
+                 if (args.containsOption("--block"))
+                     options.blockSize = juce::jmax(1, args.getValueForOption("--block").getIntValue());
+
+                 if (args.containsOption("--rate"))
+                     options.sampleRate = juce::jmax(8000.0, args.getValueForOption("--rate").getDoubleValue());
+
+                 if (args.containsOption("--seconds"))
+                     options.secondsPerStep = juce::jmax(0.1, args.getValueForOption("--seconds").getDoubleValue());
+
+                 if (args.containsOption("--csv"))
+                     options.csvFile = args.getFileForOption("--csv");
+
+                 options.paced = ! args.containsOption("--unpaced");
+                 options.kernelModes = args.containsOption("--kernel");
+
+                 if (options.kernelModes)
+                     runKernelModes(options);
+                 else
+                     run(options);
+             } };
+}
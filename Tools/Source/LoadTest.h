@@ -0,0 +1,38 @@
+/*
+  ==============================================================================
+
+    LoadTest.h
+    "loadtest" command: runs many Squeeze1 instances across worker threads the
+    way a host's parallel graph would, and reports how it scales.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+//==============================================================================
+namespace LoadTest
+{
+    struct Options
+    {
+        juce::Array<int> instanceCounts { 1, 2, 4, 8, 16, 32, 64, 128, 256 };
+        int numThreads = juce::jmax(1, juce::SystemStats::getNumCpus() - 1);
+        int blockSize = 256;
+        double sampleRate = 48000.0;
+        double secondsPerStep = 5.0;
+        bool paced = true;         // Wait for each period like a host; otherwise run flat out
+        juce::File csvFile;        // Optional, one row per instance count
+        bool kernelModes = false;  // Time CompressorKernel in each detector mode instead
+    };
+
+    int run(const Options& options);
+
+    // Single-threaded cost of each topology/auto-release combination, relative
+    // to plain feed-forward, on secondsPerStep of test signal
+    int runKernelModes(const Options& options);
+
+    juce::ConsoleApplication::Command createCommand();
+}
@@ -0,0 +1,30 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Squeeze1Cli: headless tools built on the plugin's own processor.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "OfflineRender.h"
+#include "LoadTest.h"
+#include "DspFuzz.h"
+#include "RealtimeCheck.h"
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    // The parameter tree and its timers expect a message manager to exist
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ConsoleApplication app;
+    app.addHelpCommand ("--help|-h", "Usage:", true);
+    app.addCommand (OfflineRender::createCommand());
+    app.addCommand (LoadTest::createCommand());
+    app.addCommand (DspFuzz::createCommand());
+    app.addCommand (RealtimeCheck::createCommand());
+
+    return app.findAndRunCommand (argc, argv);
+}
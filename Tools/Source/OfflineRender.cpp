@@ -0,0 +1,402 @@
+/*
+  ==============================================================================
+
+    OfflineRender.cpp
+
+  ==============================================================================
+*/
+
+#include "OfflineRender.h"
+#include <iostream>
+
+namespace
+{
+    // A segment's envelope starts from zero instead of from the serial state.
+    // Every sample either attacks or releases, and both contract that error, so
+    // after t seconds it is at most e^(-t / tau) of the initial envelope, tau
+    // being the slower of the two time constants. Twelve time constants puts
+    // it below 1e-5 of full scale before makeup gain.
+    constexpr double preRollTimeConstants = 12.0;
+
+    //==============================================================================
+    class SegmentJob : public juce::ThreadPoolJob
+    {
+    public:
+        SegmentJob(std::unique_ptr<Squeeze1AudioProcessor> processorToUse, const juce::File& file,
+                   juce::int64 preRollStart, juce::int64 segmentStart, juce::int64 segmentEnd,
+                   double sampleRate, int blockSize)
+            : juce::ThreadPoolJob("Squeeze1 segment"),
+              processor(std::move(processorToUse)), inputFile(file),
+              preRollStartSample(preRollStart), startSample(segmentStart), endSample(segmentEnd),
+              rate(sampleRate), samplesPerBlock(blockSize)
+        {
+        }
+
+        JobStatus runJob() override
+        {
+            auto numChannels = processor->getTotalNumOutputChannels();
+
+            // Each job maps just its own section, so readers never share state
+            juce::AudioFormatManager formatManager;
+            formatManager.registerBasicFormats();
+
+            std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader;
+
+            if (auto* format = formatManager.findFormatForFileExtension(inputFile.getFileExtension()))
+                reader.reset(format->createMemoryMappedReader(inputFile));
+
+            if (reader == nullptr || ! reader->mapSectionOfFile({ preRollStartSample, endSample }))
+            {
+                errorMessage = "Couldn't memory-map " + inputFile.getFullPathName();
+                return jobHasFinished;
+            }
+
+            processor->prepareToPlay(rate, samplesPerBlock);
+
+            output.setSize(numChannels, (int) (endSample - startSample));
+            juce::AudioBuffer<float> block(numChannels, samplesPerBlock);
+            juce::MidiBuffer midi;
+
+            for (auto position = preRollStartSample; position < endSample;)
+            {
+                // Pre-roll blocks stop at the segment start so it lands on a block boundary
+                auto blockEnd = position < startSample ? startSample : endSample;
+                auto numSamples = (int) juce::jmin((juce::int64) samplesPerBlock, blockEnd - position);
+
+                reader->read(&block, 0, numSamples, position, true, true);
+
+                juce::AudioBuffer<float> view(block.getArrayOfWritePointers(), numChannels, numSamples);
+                processor->processBlock(view, midi);
+
+                if (position >= startSample)
+                    for (int channel = 0; channel < numChannels; ++channel)
+                        output.copyFrom(channel, (int) (position - startSample), view, channel, 0, numSamples);
+
+                // Telemetry should describe the segment, not its warm-up
+                if (position + numSamples == startSample)
+                    processor->getTelemetry().reset();
+
+                position += numSamples;
+
+                if (shouldExit())
+                    break;
+            }
+
+            processor->releaseResources();
+            return jobHasFinished;
+        }
+
+        std::unique_ptr<Squeeze1AudioProcessor> processor;
+        juce::AudioBuffer<float> output;
+        juce::String errorMessage;
+
+    private:
+        juce::File inputFile;
+        juce::int64 preRollStartSample, startSample, endSample;
+        double rate;
+        int samplesPerBlock;
+
+        JUCE_DECLARE_NON_COPYABLE (SegmentJob)
+    };
+
+    //==============================================================================
+    // Continues a single processor across the whole file, segment by segment,
+    // as the reference the stitched output is compared against.
+    class SerialReference
+    {
+    public:
+        SerialReference(std::unique_ptr<Squeeze1AudioProcessor> processorToUse, juce::AudioFormatReader& source, int blockSize)
+            : processor(std::move(processorToUse)), reader(source), samplesPerBlock(blockSize)
+        {
+            processor->prepareToPlay(reader.sampleRate, samplesPerBlock);
+            block.setSize(processor->getTotalNumOutputChannels(), samplesPerBlock);
+        }
+
+        // Returns the largest absolute difference over this stretch of the file
+        float compare(const juce::AudioBuffer<float>& rendered, juce::int64 startSample)
+        {
+            float maxError = 0.0f;
+            juce::MidiBuffer midi;
+
+            for (int offset = 0; offset < rendered.getNumSamples(); offset += samplesPerBlock)
+            {
+                auto numSamples = juce::jmin(samplesPerBlock, rendered.getNumSamples() - offset);
+                reader.read(&block, 0, numSamples, startSample + offset, true, true);
+
+                juce::AudioBuffer<float> view(block.getArrayOfWritePointers(), block.getNumChannels(), numSamples);
+                processor->processBlock(view, midi);
+
+                for (int channel = 0; channel < view.getNumChannels(); ++channel)
+                {
+                    auto* expected = view.getReadPointer(channel);
+                    auto* actual = rendered.getReadPointer(channel, offset);
+
+                    for (int i = 0; i < numSamples; ++i)
+                        maxError = juce::jmax(maxError, std::abs(expected[i] - actual[i]));
+                }
+            }
+
+            return maxError;
+        }
+
+    private:
+        std::unique_ptr<Squeeze1AudioProcessor> processor;
+        juce::AudioFormatReader& reader;
+        juce::AudioBuffer<float> block;
+        int samplesPerBlock;
+    };
+}
+
+//==============================================================================
+std::unique_ptr<Squeeze1AudioProcessor> OfflineRender::createProcessor(const Options& options, double sampleRate, int numChannels)
+{
+    auto processor = std::make_unique<Squeeze1AudioProcessor>();
+
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+    layout.outputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+
+    if (! processor->setBusesLayout(layout))
+        juce::ConsoleApplication::fail("Squeeze1 doesn't support " + juce::String(numChannels) + " channels");
+
+    if (options.stateFile != juce::File())
+    {
+        juce::MemoryBlock state;
+
+        if (! options.stateFile.loadFileAsData(state))
+            juce::ConsoleApplication::fail("Couldn't read " + options.stateFile.getFullPathName());
+
+        processor->setStateInformation(state.getData(), (int) state.getSize());
+    }
+
+    for (auto& parameterID : options.parameterValues.getAllKeys())
+    {
+        auto* parameter = processor->apvts.getParameter(parameterID);
+
+        if (parameter == nullptr)
+            juce::ConsoleApplication::fail("Unknown parameter " + parameterID);
+
+        auto value = options.parameterValues[parameterID].getFloatValue();
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    processor->setRateAndBufferSizeDetails(sampleRate, options.blockSize);
+    processor->setNonRealtime(true);
+    return processor;
+}
+
+double OfflineRender::getConvergedPreRollSeconds(Squeeze1AudioProcessor& processor)
+{
+    auto attackMs = processor.apvts.getRawParameterValue("ATTACK")->load();
+    auto releaseMs = processor.apvts.getRawParameterValue("RELEASE")->load();
+
+    // The auto-release slow stage is the slowest part of the detector when it's on
+    if (processor.apvts.getRawParameterValue("AUTO_RELEASE")->load() > 0.5f)
+        return preRollTimeConstants * CompressorKernel::slowStageTimeScale * juce::jmax(attackMs, releaseMs) / 1000.0;
+
+    return preRollTimeConstants * juce::jmax(attackMs, releaseMs) / 1000.0;
+}
+
+int OfflineRender::render(const Options& options)
+{
+    // The output is deleted before rendering starts, which would take the input with it
+    if (options.outputFile.getLinkedTarget() == options.inputFile.getLinkedTarget())
+        juce::ConsoleApplication::fail("The output can't be the input file");
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    auto* inputFormat = formatManager.findFormatForFileExtension(options.inputFile.getFileExtension());
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader;
+
+    if (inputFormat != nullptr)
+        reader.reset(inputFormat->createMemoryMappedReader(options.inputFile));
+
+    if (reader == nullptr || ! reader->mapEntireFile())
+        juce::ConsoleApplication::fail("Couldn't memory-map " + options.inputFile.getFullPathName()
+                                         + " (WAV and AIFF are supported)");
+
+    auto sampleRate = reader->sampleRate;
+    auto numChannels = (int) reader->numChannels;
+    auto lengthInSamples = reader->lengthInSamples;
+
+    auto* outputFormat = formatManager.findFormatForFileExtension(options.outputFile.getFileExtension());
+
+    if (outputFormat == nullptr)
+        juce::ConsoleApplication::fail("Unsupported output format " + options.outputFile.getFileExtension());
+
+    options.outputFile.deleteFile();
+    auto outputStream = options.outputFile.createOutputStream();
+
+    if (outputStream == nullptr)
+        juce::ConsoleApplication::fail("Couldn't create " + options.outputFile.getFullPathName());
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(outputFormat->createWriterFor(outputStream.get(), sampleRate, (unsigned int) numChannels,
+                                                                                  (int) reader->bitsPerSample, {}, 0));
+
+    if (writer == nullptr)
+        juce::ConsoleApplication::fail("Couldn't create a writer for " + options.outputFile.getFullPathName());
+
+    outputStream.release(); // Now owned by the writer
+
+    auto preRollSeconds = options.preRollSeconds;
+
+    if (preRollSeconds < 0.0)
+        preRollSeconds = getConvergedPreRollSeconds(*createProcessor(options, sampleRate, numChannels));
+
+    auto segmentSamples = juce::jmax((juce::int64) options.blockSize, (juce::int64) (options.segmentSeconds * sampleRate));
+    auto preRollSamples = (juce::int64) (preRollSeconds * sampleRate);
+    auto numSegments = (int) ((lengthInSamples + segmentSamples - 1) / segmentSamples);
+
+    std::cout << "Rendering " << numSegments << " segment(s) of " << options.segmentSeconds << "s on "
+              << options.numThreads << " thread(s), " << preRollSeconds << "s pre-roll" << std::endl;
+
+    std::unique_ptr<juce::FileOutputStream> telemetryStream;
+
+    if (options.telemetryFile != juce::File())
+    {
+        options.telemetryFile.deleteFile();
+        telemetryStream = options.telemetryFile.createOutputStream();
+
+        if (telemetryStream != nullptr)
+            *telemetryStream << "segment," << BlockTelemetry::Snapshot::getCsvHeader() << "\n";
+    }
+
+    std::unique_ptr<SerialReference> reference;
+
+    if (options.verify)
+        reference = std::make_unique<SerialReference>(createProcessor(options, sampleRate, numChannels), *reader, options.blockSize);
+
+    // Jobs are queued in file order and picked up by whichever worker is free.
+    // Only a bounded window is in flight, since finished segments wait in
+    // memory until every earlier one has been written.
+    // Declared before the pool, so if fail() throws, the pool has stopped
+    // running them before they're destroyed
+    std::vector<std::unique_ptr<SegmentJob>> jobs((size_t) numSegments);
+    juce::ThreadPool pool(options.numThreads);
+    auto maxInFlight = options.numThreads + 2;
+    int nextToSubmit = 0;
+
+    auto submitUpTo = [&] (int limit)
+    {
+        for (; nextToSubmit < juce::jmin(limit, numSegments); ++nextToSubmit)
+        {
+            auto start = (juce::int64) nextToSubmit * segmentSamples;
+            auto end = juce::jmin(lengthInSamples, start + segmentSamples);
+
+            auto& job = jobs[(size_t) nextToSubmit];
+            job = std::make_unique<SegmentJob>(createProcessor(options, sampleRate, numChannels), options.inputFile,
+                                               juce::jmax((juce::int64) 0, start - preRollSamples), start, end,
+                                               sampleRate, options.blockSize);
+            pool.addJob(job.get(), false);
+        }
+    };
+
+    submitUpTo(maxInFlight);
+
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+    float maxError = 0.0f;
+
+    for (int segment = 0; segment < numSegments; ++segment)
+    {
+        auto& job = jobs[(size_t) segment];
+        pool.waitForJobToFinish(job.get(), -1);
+
+        if (job->errorMessage.isNotEmpty())
+        {
+            pool.removeAllJobs(true, -1); // ~ThreadPool only waits a few seconds
+            juce::ConsoleApplication::fail(job->errorMessage);
+        }
+
+        writer->writeFromAudioSampleBuffer(job->output, 0, job->output.getNumSamples());
+
+        if (reference != nullptr)
+            maxError = juce::jmax(maxError, reference->compare(job->output, (juce::int64) segment * segmentSamples));
+
+        if (telemetryStream != nullptr)
+            *telemetryStream << segment << "," << job->processor->getTelemetry().getSnapshot().toCsvRow() << "\n";
+
+        job.reset();
+        submitUpTo(segment + 1 + maxInFlight);
+    }
+
+    writer.reset();
+
+    auto seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+    std::cout << "Rendered " << (double) lengthInSamples / sampleRate << "s of audio in " << seconds << "s" << std::endl;
+
+    if (options.traceFile != juce::File() && ! TraceEvents::writeChromeJson(options.traceFile))
+        std::cout << "No trace written (build with SQUEEZE1_ENABLE_TRACING=1)" << std::endl;
+
+    if (reference != nullptr)
+    {
+        std::cout << "Max difference from serial render: " << maxError
+                  << " (tolerance " << options.tolerance << ")" << std::endl;
+
+        if (maxError > options.tolerance)
+            juce::ConsoleApplication::fail("Stitched output differs from the serial render", 2);
+    }
+
+    return 0;
+}
+
+//==============================================================================
+juce::ConsoleApplication::Command OfflineRender::createCommand()
+{
+    return { "render",
+             "render <input> <output> [--threads=N] [--segment=seconds] [--preroll=seconds] [--block=N] "
+             "[--state=file] [--param=ID=value ...] [--verify] [--tolerance=x] [--telemetry=file.csv] [--trace=file.json]",
+             "Renders a file through Squeeze1 in parallel segments.",
+             "Splits the input into segments, processes each on its own plugin instance with a pre-roll so the\n"
+             "envelope has converged by the segment start, and writes the segments back in order.\n"
+             "The pre-roll defaults to 12 time constants of the slower of attack and release (ten times that with\n"
+             "auto release, for its slow stage), which bounds the difference from a single-instance render to\n"
+             "about 1e-5 of full scale before makeup gain;\n"
+             "--verify renders serially alongside and fails if the difference exceeds --tolerance (default 1e-4).",
+             [] (const juce::ArgumentList& args)
+             {
+                 args.checkMinNumArguments(3);
+
+                 Options options;
+                 options.inputFile = args[1].resolveAsExistingFile();
+                 options.outputFile = args[2].resolveAsFile();
+
+                 if (args.containsOption("--threads"))
+                     options.numThreads = juce::jmax(1, args.getValueForOption("--threads").getIntValue());
+
+                 if (args.containsOption("--segment"))
+                     options.segmentSeconds = juce::jmax(0.1, args.getValueForOption("--segment").getDoubleValue());
+
+                 if (args.containsOption("--preroll"))
+                     options.preRollSeconds = juce::jmax(0.0, args.getValueForOption("--preroll").getDoubleValue());
+
+                 if (args.containsOption("--block"))
+                     options.blockSize = juce::jmax(1, args.getValueForOption("--block").getIntValue());
+
+                 if (args.containsOption("--state"))
+                     options.stateFile = args.getExistingFileForOption("--state");
+
+                 if (args.containsOption("--tolerance"))
+                     options.tolerance = args.getValueForOption("--tolerance").getDoubleValue();
+
+                 if (args.containsOption("--telemetry"))
+                     options.telemetryFile = args.getFileForOption("--telemetry");
+
+                 if (args.containsOption("--trace"))
+                     options.traceFile = args.getFileForOption("--trace");
+
+                 options.verify = args.containsOption("--verify");
+
+                 for (auto& arg : args.arguments)
+                 {
+                     if (arg.text.startsWith("--param="))
+                     {
+                         auto assignment = arg.text.fromFirstOccurrenceOf("--param=", false, false);
+                         options.parameterValues.set(assignment.upToFirstOccurrenceOf("=", false, false),
+                                                     assignment.fromFirstOccurrenceOf("=", false, false));
+                     }
+                 }
+
+                 render(options);
+             } };
+}
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    OfflineRender.h
+    "render" command: processes a long file through Squeeze1 in parallel
+    segments, each warmed up with a pre-roll, and streams the stitched result.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+//==============================================================================
+namespace OfflineRender
+{
+    struct Options
+    {
+        juce::File inputFile;
+        juce::File outputFile;
+        juce::File stateFile;                   // Optional getStateInformation() dump
+        juce::StringPairArray parameterValues;  // Parameter ID -> plain value
+        int numThreads = juce::SystemStats::getNumCpus();
+        int blockSize = 512;
+        double segmentSeconds = 60.0;
+        double preRollSeconds = -1.0;           // Negative: derived from attack/release
+        bool verify = false;
+        double tolerance = 1.0e-4;
+        juce::File telemetryFile;               // Optional CSV, one row per segment
+        juce::File traceFile;                   // Optional Chrome trace (tracing builds)
+    };
+
+    // Creates a processor with the options' state and parameters applied and
+    // its buses/rate set up; prepareToPlay is left to the caller.
+    std::unique_ptr<Squeeze1AudioProcessor> createProcessor(const Options& options, double sampleRate, int numChannels);
+
+    // The pre-roll after which a segment's envelope matches a serial render to
+    // within the stated tolerance (see render()).
+    double getConvergedPreRollSeconds(Squeeze1AudioProcessor& processor);
+
+    // Returns 0 on success; throws via ConsoleApplication::fail on errors
+    int render(const Options& options);
+
+    juce::ConsoleApplication::Command createCommand();
+}
@@ -0,0 +1,235 @@
+/*
+  ==============================================================================
+
+    RealtimeCheck.cpp
+
+  ==============================================================================
+*/
+
+#include "RealtimeCheck.h"
+#include "OfflineRender.h"
+#include <cstdlib>
+#include <iostream>
+
+#if JUCE_LINUX || JUCE_BSD || JUCE_MAC
+ #include <csignal>
+ #include <pthread.h>
+ #include <sys/wait.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+   #if SQUEEZE1_REALTIME_CHECKS && (JUCE_LINUX || JUCE_BSD || JUCE_MAC)
+    void* volatile allocationSink = nullptr;
+
+    // Runs the violation in a child process and expects it to be killed by the
+    // checker's abort. If it survives, the hooks aren't bound in this process
+    // and a clean run below would prove nothing.
+    bool checkerCatches(const char* what, void (*violation)())
+    {
+        std::cout << "Self-test: armed " << what << " should abort (a violation report below is expected)" << std::endl;
+
+        auto child = fork();
+
+        if (child == 0)
+        {
+            {
+                RealtimeSafety::ScopedAudioThread armed;
+                violation();
+            }
+
+            _exit(0);
+        }
+
+        int status = 0;
+        return child > 0 && waitpid(child, &status, 0) == child && WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+    }
+
+    void allocate()
+    {
+        // A direct call can't be elided the way a new-expression can
+        allocationSink = ::operator new(16);
+    }
+
+   #if defined (__GLIBC__)
+    void allocateWithMalloc()
+    {
+        allocationSink = std::malloc(16);
+    }
+   #endif
+
+    void lockMutex()
+    {
+        static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+        pthread_mutex_lock(&mutex);
+        pthread_mutex_unlock(&mutex);
+    }
+   #endif
+
+    //==============================================================================
+    class Session
+    {
+    public:
+        Session(juce::int64 seed, int blocks) : random(seed), blocksPerPhase(blocks) {}
+
+        void createProcessor(double sampleRate, int samplesPerBlock, int numChannels)
+        {
+            OfflineRender::Options options;
+            options.blockSize = samplesPerBlock;
+            processor = OfflineRender::createProcessor(options, sampleRate, numChannels);
+            prepare(sampleRate, samplesPerBlock, numChannels);
+        }
+
+        void prepare(double sampleRate, int samplesPerBlock, int numChannels)
+        {
+            currentBlockSize = samplesPerBlock;
+            processor->setRateAndBufferSizeDetails(sampleRate, samplesPerBlock);
+            processor->prepareToPlay(sampleRate, samplesPerBlock);
+            buffer.setSize(numChannels, samplesPerBlock * 4);
+        }
+
+        // Host-sized blocks, with the empty and oversized ones hosts also send
+        void processBlocks(bool automate)
+        {
+            for (int i = 0; i < blocksPerPhase; ++i)
+            {
+                auto numSamples = random.nextInt(8) == 0 ? random.nextInt(3) * currentBlockSize * 2
+                                                         : 1 + random.nextInt(currentBlockSize);
+
+                for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                    for (int sample = 0; sample < numSamples; ++sample)
+                        buffer.setSample(channel, sample, random.nextFloat() * 2.0f - 1.0f);
+
+                if (automate)
+                {
+                    // Hosts deliver automation on the audio thread, just before the block
+                    auto& parameters = processor->getParameters();
+                    auto* parameter = parameters[random.nextInt(parameters.size())];
+
+                    RealtimeSafety::ScopedAudioThread armed;
+                    parameter->setValue(random.nextFloat());
+                }
+
+                juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), 0, numSamples);
+                processor->processBlock(block, midi); // Arms the checker itself
+                ++numBlocks;
+            }
+        }
+
+        void changeParametersFromEditor()
+        {
+            for (auto* parameter : processor->getParameters())
+                parameter->setValueNotifyingHost(random.nextFloat());
+        }
+
+        void restoreState()
+        {
+            juce::MemoryBlock state;
+            processor->getStateInformation(state);
+            changeParametersFromEditor();
+            processor->setStateInformation(state.getData(), (int) state.getSize());
+        }
+
+        void changeLayout(int numChannels, double sampleRate, int samplesPerBlock)
+        {
+            processor->releaseResources();
+
+            juce::AudioProcessor::BusesLayout layout;
+            layout.inputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+            layout.outputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+
+            if (! processor->setBusesLayout(layout))
+                juce::ConsoleApplication::fail("Squeeze1 rejected a " + juce::String(numChannels) + "-channel layout");
+
+            prepare(sampleRate, samplesPerBlock, numChannels);
+        }
+
+        int getNumBlocks() const { return numBlocks; }
+
+    private:
+        juce::Random random;
+        int blocksPerPhase;
+        std::unique_ptr<Squeeze1AudioProcessor> processor;
+        juce::AudioBuffer<float> buffer;
+        juce::MidiBuffer midi;
+        int currentBlockSize = 0;
+        int numBlocks = 0;
+    };
+}
+
+//==============================================================================
+int RealtimeCheck::run(const Options& options)
+{
+   #if ! SQUEEZE1_REALTIME_CHECKS
+    juce::ignoreUnused(options);
+    juce::ConsoleApplication::fail("The checker isn't compiled in; build Squeeze1Cli in Debug or with SQUEEZE1_REALTIME_CHECKS=1");
+    return 1;
+   #else
+   #if JUCE_LINUX || JUCE_BSD || JUCE_MAC
+    if (! checkerCatches("operator new", allocate) || ! checkerCatches("pthread_mutex_lock", lockMutex))
+        juce::ConsoleApplication::fail("The checker's hooks aren't active in this process, so nothing would be caught");
+
+   #if defined (__GLIBC__)
+    if (! checkerCatches("malloc", allocateWithMalloc))
+        juce::ConsoleApplication::fail("The checker's malloc hook isn't active in this process");
+   #endif
+   #endif
+
+    Session session(options.seed, options.blocksPerPhase);
+
+    std::cout << "prepareToPlay, then plain blocks" << std::endl;
+    session.createProcessor(48000.0, 512, 2);
+    session.processBlocks(false);
+
+    std::cout << "Automation on the audio thread" << std::endl;
+    session.processBlocks(true);
+
+    std::cout << "Parameter changes from the editor" << std::endl;
+    session.changeParametersFromEditor();
+    session.processBlocks(false);
+
+    std::cout << "State restore" << std::endl;
+    session.restoreState();
+    session.processBlocks(true);
+
+    std::cout << "Re-prepare at a new rate and block size" << std::endl;
+    session.prepare(96000.0, 128, 2);
+    session.processBlocks(true);
+
+    std::cout << "Bus layout changes" << std::endl;
+    session.changeLayout(1, 44100.0, 1024);
+    session.processBlocks(true);
+    session.changeLayout(2, 48000.0, 256);
+    session.processBlocks(true);
+
+    std::cout << "No real-time violations in " << session.getNumBlocks() << " blocks" << std::endl;
+    return 0;
+   #endif
+}
+
+//==============================================================================
+juce::ConsoleApplication::Command RealtimeCheck::createCommand()
+{
+    return { "rtcheck",
+             "rtcheck [--seed=N] [--blocks=N]",
+             "Runs processBlock through a host lifecycle with the real-time checker armed.",
+             "First confirms in child processes that an armed allocation (operator new, and malloc with glibc)\n"
+             "and mutex lock are caught, then calls processBlock through prepareToPlay, automation delivered on\n"
+             "the audio thread, editor parameter changes, state restore, re-preparing and mono/stereo layout\n"
+             "changes, with empty and oversized blocks mixed in. Any allocation or lock inside processBlock\n"
+             "aborts with a report.\n"
+             "Needs a build with the checker compiled in (Debug, or SQUEEZE1_REALTIME_CHECKS=1).",
+             [] (const juce::ArgumentList& args)
+             {
+                 Options options;
+
+                 if (args.containsOption("--seed"))
+                     options.seed = args.getValueForOption("--seed").getLargeIntValue();
+
+                 if (args.containsOption("--blocks"))
+                     options.blocksPerPhase = juce::jmax(1, args.getValueForOption("--blocks").getIntValue());
+
+                 run(options);
+             } };
+}
@@ -0,0 +1,29 @@
+/*
+  ==============================================================================
+
+    RealtimeCheck.h
+    "rtcheck" command: drives processBlock through a host's lifecycle with
+    the real-time safety checker armed, and fails on any violation.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+namespace RealtimeCheck
+{
+    struct Options
+    {
+        juce::int64 seed = 1;
+        int blocksPerPhase = 200;
+    };
+
+    // Returns 0 on success. A violation aborts the process, so a non-zero exit
+    // status (or abort signal) is the failure
+    int run(const Options& options);
+
+    juce::ConsoleApplication::Command createCommand();
+}
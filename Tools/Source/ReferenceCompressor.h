@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    ReferenceCompressor.h
+    Frozen copy of the scalar algorithm, one sample at a time, with the
+    per-channel envelopes introduced when processBlock moved to fixed-size
+    chunks. (The original processBlock shared one envelope across channels;
+    the per-channel semantics are what's defined as correct from then on.)
+
+    Don't optimize or "fix" this file. It's the model the "fuzz" command
+    checks CompressorKernel and processBlock against, so a change here
+    changes what counts as correct.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class ReferenceCompressor
+{
+public:
+    struct Parameters
+    {
+        float thresholdDb = 0.0f;
+        float ratio = 1.0f;
+        float attackMs = 0.1f;
+        float releaseMs = 10.0f;
+        float gainDb = 0.0f;
+    };
+
+    void prepare(double newSampleRate, int numChannels)
+    {
+        sampleRate = newSampleRate;
+        envelopes.assign((size_t) numChannels, 0.0f);
+    }
+
+    // Processes the whole buffer in one pass; the envelopes carry over to the next call
+    void process(juce::AudioBuffer<float>& buffer, const Parameters& parameters)
+    {
+        juce::ScopedNoDenormals noDenormals;
+
+        auto linearGain = juce::Decibels::decibelsToGain(parameters.gainDb);
+        auto linearThreshold = juce::Decibels::decibelsToGain(parameters.thresholdDb);
+        auto ratio = parameters.ratio;
+
+        float attackTimeInSeconds = parameters.attackMs / 1000.0f;
+        float attackCoeff = 1.0f - std::exp(-1.0f / (attackTimeInSeconds * sampleRate));
+
+        float releaseTimeInSeconds = parameters.releaseMs / 1000.0f;
+        float releaseCoeff = 1.0f - std::exp(-1.0f / (releaseTimeInSeconds * sampleRate));
+
+        jassert(buffer.getNumChannels() <= (int) envelopes.size());
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            auto* channelData = buffer.getWritePointer(channel);
+            auto& envelope = envelopes[(size_t) channel];
+
+            for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+            {
+                auto& sampleValue = channelData[sample];
+
+                if (std::abs(sampleValue) > linearThreshold){
+                    // Calculate the excess above the threshold
+                    float excess = std::abs(sampleValue) - linearThreshold;
+
+                    // Smooth the gain reduction using the envelope
+                    float targetEnvelope = excess / ratio; // Amount of reduction based on ratio
+                    envelope = envelope + attackCoeff * (targetEnvelope - envelope); // Attack smoothing
+
+                    // Apply compression
+                    float compressedSample = linearThreshold + envelope;
+                    sampleValue = (sampleValue > 0.0f ? compressedSample : -compressedSample); // Preserve polarity
+                }
+                else {
+                    // Release the envelope
+                    envelope = envelope - releaseCoeff * envelope;
+                    envelope = juce::jmax(envelope, 0.0f); // Ensure envelope doesn't go negative
+                }
+
+                // Apply final gain
+                sampleValue *= linearGain;
+            }
+        }
+    }
+
+private:
+    double sampleRate = 44100.0;
+    std::vector<float> envelopes;
+};